@@ -0,0 +1,64 @@
+#include "Arena.hpp"
+#include "Compiler.hpp"
+#include <cstdlib>
+#include <cstdint>
+
+Arena::Arena() : blocks(), curr(nullptr), left(0), cleanups(nullptr) {
+    newBlock(BLOCK_SIZE);
+}
+
+Arena::~Arena() {
+    release();
+    free(blocks[0]);
+}
+
+Arena &Arena::instance() {
+    return Compiler::current().codeArena();
+}
+
+void Arena::newBlock(size_t min_size) {
+    size_t size = min_size > BLOCK_SIZE ? min_size : BLOCK_SIZE;
+    curr = static_cast<char*>(malloc(size));
+    if(!curr){
+        throw bad_alloc();
+    }
+    blocks.push_back(curr);
+    left = size;
+}
+
+void* Arena::allocate(size_t size, size_t align) {
+    size_t padding = (align - (reinterpret_cast<uintptr_t>(curr) & (align - 1))) & (align - 1);
+    if(padding + size > left){
+        newBlock(size + align);
+        padding = (align - (reinterpret_cast<uintptr_t>(curr) & (align - 1))) & (align - 1);
+    }
+
+    void* ptr = curr + padding;
+    curr += padding + size;
+    left -= padding + size;
+    return ptr;
+}
+
+void Arena::onRelease(void (*destroy)(void*), void* obj) {
+    Cleanup* cleanup = static_cast<Cleanup*>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+    cleanup->destroy = destroy;
+    cleanup->obj = obj;
+    cleanup->next = cleanups;
+    cleanups = cleanup;
+}
+
+void Arena::release() {
+    while(cleanups){
+        // the cleanup record itself lives in the arena, read it before destroying
+        Cleanup* next = cleanups->next;
+        cleanups->destroy(cleanups->obj);
+        cleanups = next;
+    }
+
+    for(size_t i = 1; i < blocks.size(); i++){
+        free(blocks[i]);
+    }
+    blocks.resize(1);
+    curr = blocks[0];
+    left = BLOCK_SIZE;
+}
@@ -0,0 +1,89 @@
+#ifndef HW5_ARENA_H
+#define HW5_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// bump allocator owning the semantic values of the function being compiled.
+// everything allocated from it is destroyed and freed at once by release()
+class Arena{
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    struct Cleanup {
+        void (*destroy)(void*);
+        void* obj;
+        Cleanup* next;
+    };
+
+    friend class Compiler;
+    Arena();
+    Arena(Arena const&);
+    void operator=(Arena const&);
+
+    vector<char*> blocks;
+    char* curr;
+    size_t left;
+    Cleanup* cleanups;
+
+    void newBlock(size_t min_size);
+public:
+    ~Arena();
+    //the arena of the current compilation
+    static Arena &instance();
+
+    void* allocate(size_t size, size_t align = alignof(max_align_t));
+
+    //runs destroy(obj) on release, in reverse order of registration
+    void onRelease(void (*destroy)(void*), void* obj);
+
+    //destroys every registered object and frees all memory but the first block
+    void release();
+};
+
+// base for classes whose instances are always allocated in the arena:
+// plain new places them there and release() runs their destructor
+template<class T>
+class ArenaObject {
+    static void destroy(void* obj){
+        static_cast<T*>(obj)->~T();
+    }
+public:
+    static void* operator new(size_t size){
+        void* obj = Arena::instance().allocate(size, alignof(T));
+        if(!is_trivially_destructible<T>::value){
+            Arena::instance().onRelease(destroy, obj);
+        }
+        return obj;
+    }
+    static void operator delete(void*){}
+};
+
+// stl allocator on top of the arena, deallocation is left to release()
+template<class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator(){}
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U>&){}
+
+    T* allocate(size_t n){
+        return static_cast<T*>(Arena::instance().allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t){}
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&){ return true; }
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&){ return false; }
+
+template<class T>
+class ArenaVector : public vector<T, ArenaAllocator<T>>, public ArenaObject<ArenaVector<T>> {};
+
+#endif //HW5_ARENA_H
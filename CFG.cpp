@@ -0,0 +1,275 @@
+#include "CFG.hpp"
+#include <algorithm>
+
+vector<int> successors(const BasicBlock& block){
+    vector<int> succs;
+    if(block.instrs.empty()){
+        return succs;
+    }
+
+    const Instr& term = block.instrs.back();
+    if(term.op == OP_BR){
+        succs.push_back(term.ops[0].id);
+    } else if(term.op == OP_COND_BR){
+        succs.push_back(term.ops[1].id);
+        if(term.ops[2].id != term.ops[1].id){
+            succs.push_back(term.ops[2].id);
+        }
+    }
+    return succs;
+}
+
+CFG::CFG(const IRFunction& func)
+: succs(func.blocks.size()), preds(func.blocks.size()), rpo(),
+  rpo_index(func.blocks.size(), -1), idom(func.blocks.size(), -1)
+{
+    int num_blocks = int(func.blocks.size());
+    for(int block = 0; block < num_blocks; block++){
+        succs[block] = successors(func.blocks[block]);
+    }
+
+    // iterative dfs for the postorder
+    vector<int> postorder;
+    vector<bool> visited(num_blocks, false);
+    vector<pair<int,size_t>> stack;
+    stack.push_back({0, 0});
+    visited[0] = true;
+    while(!stack.empty()){
+        int block = stack.back().first;
+        size_t& next = stack.back().second;
+        if(next < succs[block].size()){
+            int succ = succs[block][next++];
+            if(!visited[succ]){
+                visited[succ] = true;
+                stack.push_back({succ, 0});
+            }
+        } else {
+            postorder.push_back(block);
+            stack.pop_back();
+        }
+    }
+
+    rpo.assign(postorder.rbegin(), postorder.rend());
+    for(int i = 0; i < int(rpo.size()); i++){
+        rpo_index[rpo[i]] = i;
+    }
+    for(int block: rpo){
+        for(int succ: succs[block]){
+            preds[succ].push_back(block);
+        }
+    }
+
+    // Cooper, Harvey and Kennedy's "A Simple, Fast Dominance Algorithm"
+    idom[0] = 0;
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(size_t i = 1; i < rpo.size(); i++){
+            int block = rpo[i];
+            int new_idom = -1;
+            for(int pred: preds[block]){
+                if(idom[pred] < 0){
+                    continue;
+                }
+                if(new_idom < 0){
+                    new_idom = pred;
+                    continue;
+                }
+                int a = pred, b = new_idom;
+                while(a != b){
+                    while(rpo_index[a] > rpo_index[b]){
+                        a = idom[a];
+                    }
+                    while(rpo_index[b] > rpo_index[a]){
+                        b = idom[b];
+                    }
+                }
+                new_idom = a;
+            }
+            if(idom[block] != new_idom){
+                idom[block] = new_idom;
+                changed = true;
+            }
+        }
+    }
+    idom[0] = -1;
+}
+
+bool CFG::dominates(int a, int b) const {
+    if(!reachable(a) || !reachable(b)){
+        return false;
+    }
+    while(b >= 0 && rpo_index[b] >= rpo_index[a]){
+        if(b == a){
+            return true;
+        }
+        b = idom[b];
+    }
+    return false;
+}
+
+vector<vector<int>> CFG::frontiers() const {
+    vector<vector<int>> df(succs.size());
+    for(int block: rpo){
+        if(preds[block].size() < 2){
+            continue;
+        }
+        for(int pred: preds[block]){
+            int runner = pred;
+            while(runner != idom[block]){
+                if(df[runner].empty() || df[runner].back() != block){
+                    df[runner].push_back(block);
+                }
+                runner = idom[runner];
+            }
+        }
+    }
+    return df;
+}
+
+vector<vector<int>> CFG::domTree() const {
+    vector<vector<int>> children(succs.size());
+    for(int block: rpo){
+        if(idom[block] >= 0){
+            children[idom[block]].push_back(block);
+        }
+    }
+    return children;
+}
+
+Operand& phiValue(IRFunction& func, Instr& phi, int i){
+    return func.extra[phi.extra_begin + 2 * i];
+}
+
+Operand& phiLabel(IRFunction& func, Instr& phi, int i){
+    return func.extra[phi.extra_begin + 2 * i + 1];
+}
+
+int phiCount(const Instr& phi){
+    return phi.extra_count / 2;
+}
+
+void renamePhiEdges(IRFunction& func, int block, int from, int to){
+    for(auto& instr: func.blocks[block].instrs){
+        if(instr.op != OP_PHI){
+            break;
+        }
+        for(int i = 0; i < phiCount(instr); i++){
+            if(phiLabel(func, instr, i).id == from){
+                phiLabel(func, instr, i).id = to;
+            }
+        }
+    }
+}
+
+void removeUnreachableBlocks(IRFunction& func){
+    CFG cfg(func);
+    int num_blocks = int(func.blocks.size());
+    if(int(cfg.rpo.size()) == num_blocks){
+        return;
+    }
+
+    // keep the reachable blocks in their original order
+    vector<int> new_idx(num_blocks, -1);
+    vector<BasicBlock> kept;
+    for(int block = 0; block < num_blocks; block++){
+        if(cfg.reachable(block)){
+            new_idx[block] = int(kept.size());
+            kept.push_back(move(func.blocks[block]));
+        }
+    }
+    func.blocks.swap(kept);
+
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.op == OP_BR){
+                instr.ops[0].id = new_idx[instr.ops[0].id];
+            } else if(instr.op == OP_COND_BR){
+                instr.ops[1].id = new_idx[instr.ops[1].id];
+                instr.ops[2].id = new_idx[instr.ops[2].id];
+            } else if(instr.op == OP_PHI){
+                // drop the edges coming from removed blocks
+                int kept_edges = 0;
+                for(int i = 0; i < phiCount(instr); i++){
+                    int pred = new_idx[phiLabel(func, instr, i).id];
+                    if(pred < 0){
+                        continue;
+                    }
+                    phiValue(func, instr, kept_edges) = phiValue(func, instr, i);
+                    phiLabel(func, instr, kept_edges) = Operand::label(pred);
+                    kept_edges++;
+                }
+                instr.extra_count = kept_edges * 2;
+            }
+        }
+    }
+}
+
+static Operand resolve(vector<Operand>& subst, Operand opnd){
+    while(opnd.kind == OPND_VALUE && subst[opnd.id].kind != OPND_NONE){
+        opnd = subst[opnd.id];
+    }
+    return opnd;
+}
+
+void substituteValues(IRFunction& func, vector<Operand>& subst){
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            forEachUse(func, instr, [&](Operand& opnd){
+                opnd = resolve(subst, opnd);
+            });
+        }
+    }
+}
+
+bool isPure(const Instr& instr){
+    switch(instr.op){
+        case OP_STORE:
+        case OP_CALL:
+        case OP_BR:
+        case OP_COND_BR:
+        case OP_RET:
+        case OP_UNREACHABLE:
+            return false;
+        default:
+            return instr.dst >= 0;
+    }
+}
+
+void removeDeadValues(IRFunction& func){
+    // mark values reachable from the side effecting instructions
+    vector<Instr*> def(func.num_values, nullptr);
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.dst >= 0){
+                def[instr.dst] = &instr;
+            }
+        }
+    }
+
+    vector<bool> live(func.num_values, false);
+    vector<Instr*> worklist;
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(!isPure(instr)){
+                worklist.push_back(&instr);
+            }
+        }
+    }
+    while(!worklist.empty()){
+        Instr* instr = worklist.back();
+        worklist.pop_back();
+        forEachUse(func, *instr, [&](Operand& opnd){
+            if(opnd.kind == OPND_VALUE && !live[opnd.id] && def[opnd.id]){
+                live[opnd.id] = true;
+                worklist.push_back(def[opnd.id]);
+            }
+        });
+    }
+
+    for(auto& block: func.blocks){
+        block.instrs.erase(remove_if(block.instrs.begin(), block.instrs.end(), [&](const Instr& instr){
+            return isPure(instr) && !live[instr.dst];
+        }), block.instrs.end());
+    }
+}
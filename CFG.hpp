@@ -0,0 +1,62 @@
+#ifndef HW5_CFG_H
+#define HW5_CFG_H
+
+#include "IR.hpp"
+
+// control flow graph of an IRFunction and the analyses the passes share.
+// only blocks reachable from the entry take part in it
+
+class CFG {
+public:
+    vector<vector<int>> succs;
+    vector<vector<int>> preds;  // predecessors that are reachable, in no particular order
+    vector<int> rpo;            // reachable blocks in reverse postorder, entry first
+    vector<int> rpo_index;      // position of each block in rpo, -1 if unreachable
+    vector<int> idom;           // immediate dominator, -1 for the entry and unreachable blocks
+
+    explicit CFG(const IRFunction& func);
+
+    bool reachable(int block) const { return rpo_index[block] >= 0; }
+    bool dominates(int a, int b) const;
+
+    //dominance frontier of every block
+    vector<vector<int>> frontiers() const;
+    //children of every block in the dominator tree
+    vector<vector<int>> domTree() const;
+};
+
+//the label operands of a block's terminator
+vector<int> successors(const BasicBlock& block);
+
+//removes blocks that can't be reached from the entry, and their phi incoming edges
+void removeUnreachableBlocks(IRFunction& func);
+
+//the incoming edges of a phi, as {value, label} operand pairs
+Operand& phiValue(IRFunction& func, Instr& phi, int i);
+Operand& phiLabel(IRFunction& func, Instr& phi, int i);
+int phiCount(const Instr& phi);
+
+//points the incoming edges from block `from` of the phis at the start of block to block `to`
+void renamePhiEdges(IRFunction& func, int block, int from, int to);
+
+//calls f on every operand the instruction reads, including call arguments and phi incoming
+template<class F>
+void forEachUse(IRFunction& func, Instr& instr, F f){
+    for(int i = 0; i < 3; i++){
+        f(instr.ops[i]);
+    }
+    for(int i = 0; i < instr.extra_count; i++){
+        f(func.extra[instr.extra_begin + i]);
+    }
+}
+
+//replaces every use of value v by subst[v] when it is set (kind != OPND_NONE), following chains
+void substituteValues(IRFunction& func, vector<Operand>& subst);
+
+//true for instructions that can be dropped when their result is unused
+bool isPure(const Instr& instr);
+
+//removes pure instructions whose results are never used
+void removeDeadValues(IRFunction& func);
+
+#endif //HW5_CFG_H
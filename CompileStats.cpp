@@ -0,0 +1,109 @@
+#include "CompileStats.hpp"
+#include <cstdio>
+#include <sys/resource.h>
+
+namespace {
+
+// peak resident set size of the process, in kilobytes. VmHWM starts over at exec, while ru_maxrss keeps
+// the peak of the process that forked us
+long peakRssKb() {
+    FILE* status = fopen("/proc/self/status", "r");
+    if(status){
+        char line[128];
+        long kb = -1;
+        while(fgets(line, sizeof(line), status)){
+            if(sscanf(line, "VmHWM: %ld kB", &kb) == 1){
+                break;
+            }
+        }
+        fclose(status);
+        if(kb >= 0){
+            return kb;
+        }
+    }
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+string seconds(double time) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.6f", time);
+    return buf;
+}
+
+}
+
+CompileStats::CompileStats() : timed(false), scan_time(0), parse_time(0), optimize_time(0), print_time(0),
+        tokens(0), reductions(0), symbol_lookups(0), entries_walked(0), instrs_emitted(0), patches_applied(0),
+        bytes_output(0) {}
+
+void CompileStats::add(const CompileStats& other) {
+    scan_time += other.scan_time;
+    parse_time += other.parse_time;
+    optimize_time += other.optimize_time;
+    print_time += other.print_time;
+    tokens += other.tokens;
+    reductions += other.reductions;
+    symbol_lookups += other.symbol_lookups;
+    entries_walked += other.entries_walked;
+    instrs_emitted += other.instrs_emitted;
+    patches_applied += other.patches_applied;
+    bytes_output += other.bytes_output;
+}
+
+void CompileStats::print(ostream& os, double total_time, bool json) const {
+    const pair<const char*, double> phases[] = {
+        {"scan", scan_time}, {"parse", parse_time}, {"optimize", optimize_time}, {"print", print_time},
+        {"total", total_time}
+    };
+    const pair<const char*, long> counters[] = {
+        {"tokens", tokens}, {"reductions", reductions}, {"symbol_lookups", symbol_lookups},
+        {"entries_walked", entries_walked}, {"instructions_emitted", instrs_emitted},
+        {"patches_applied", patches_applied}, {"bytes_output", bytes_output}, {"peak_rss_kb", peakRssKb()}
+    };
+
+    if(json){
+        os << "{\"phases\": {";
+        const char* sep = "";
+        for(auto& phase: phases){
+            os << sep << "\"" << phase.first << "\": " << seconds(phase.second);
+            sep = ", ";
+        }
+        os << "}, \"counters\": {";
+        sep = "";
+        for(auto& counter: counters){
+            os << sep << "\"" << counter.first << "\": " << counter.second;
+            sep = ", ";
+        }
+        os << "}}" << endl;
+        return;
+    }
+
+    char line[96];
+    os << "time report (phases of parallel compilations add up):" << endl;
+    for(auto& phase: phases){
+        snprintf(line, sizeof(line), "  %-22s %12s s", phase.first, seconds(phase.second).c_str());
+        os << line << endl;
+    }
+    for(auto& counter: counters){
+        snprintf(line, sizeof(line), "  %-22s %12ld", counter.first, counter.second);
+        os << line << endl;
+    }
+}
+
+double secondsSince(CompileStats::Clock::time_point start) {
+    return chrono::duration<double>(CompileStats::Clock::now() - start).count();
+}
+
+PhaseTimer::PhaseTimer(const CompileStats& stats, double& phase_time)
+        : phase(stats.timed ? &phase_time : nullptr),
+          start(stats.timed ? CompileStats::Clock::now() : CompileStats::Clock::time_point()) {}
+
+PhaseTimer::~PhaseTimer() {
+    if(phase){
+        *phase += secondsSince(start);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef HW5_COMPILE_STATS_H
+#define HW5_COMPILE_STATS_H
+
+#include <chrono>
+#include <ostream>
+
+using namespace std;
+
+// counters of a compilation and the wall time of its phases, for --time-report.
+// the counters are always kept, the phases are only timed when timed is set, since reading the clock
+// around every token isn't free
+struct CompileStats {
+    typedef chrono::steady_clock Clock;
+
+    bool timed;
+
+    // seconds spent in each phase. parse is the grammar actions (semantic checks and code emission),
+    // without the scanning, optimizing and printing that happen while parsing
+    double scan_time;
+    double parse_time;
+    double optimize_time;
+    double print_time;
+
+    long tokens;
+    long reductions;
+    long symbol_lookups;
+    long entries_walked; // overloads compared and scope entries popped
+    long instrs_emitted;
+    long patches_applied;
+    long bytes_output;
+
+    CompileStats();
+
+    //adds in the counters and times of a separate compilation (of a function or of another file)
+    void add(const CompileStats& other);
+
+    //prints the phases, the total wall time, the counters and the peak RSS of the process, as text or JSON
+    void print(ostream& os, double total_time, bool json) const;
+};
+
+//seconds from start until now
+double secondsSince(CompileStats::Clock::time_point start);
+
+// adds the time from its construction to its destruction to a phase, if the stats are timed
+class PhaseTimer {
+    double* phase;
+    CompileStats::Clock::time_point start;
+
+    PhaseTimer(PhaseTimer const&);
+    void operator=(PhaseTimer const&);
+public:
+    PhaseTimer(const CompileStats& stats, double& phase_time);
+    ~PhaseTimer();
+};
+
+#endif //HW5_COMPILE_STATS_H
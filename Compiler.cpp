@@ -0,0 +1,621 @@
+#include "Compiler.hpp"
+#include "bison_code.hpp"
+#include "FastScanner.hpp"
+#include "OutWriter.hpp"
+#include "ThreadPool.hpp"
+#include "parser.tab.hpp"
+#include <fcntl.h>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <unistd.h>
+
+// the reentrant scanner's interface, generated by flex
+int scanToken(YYSTYPE* yylval_param, yyscan_t yyscanner);
+int yylex_init(yyscan_t* scanner);
+int yylex_destroy(yyscan_t scanner);
+void yyset_in(FILE* in, yyscan_t scanner);
+int yyget_lineno(yyscan_t scanner);
+
+int yylex(YYSTYPE* lval, YYLTYPE* lloc, Compiler& compiler) {
+    int token = compiler.nextToken(lval);
+    lloc->first_line = lloc->last_line = compiler.lineno();
+    return token;
+}
+
+namespace {
+
+thread_local Compiler* current_compiler = nullptr;
+
+// token code of a lexical error, replayed where the scanner found it
+const int LEXICAL_ERROR = -1;
+
+// version of the code the compiler generates, part of every cache key. bump it with any change to the
+// generated code (the grammar actions, the passes, the printers), so the cached functions of older
+// versions are no longer reused
+const int CODEGEN_VERSION = 1;
+
+bool isType(int token) {
+    return token == INT || token == BYTE || token == BOOL;
+}
+
+Type tokenType(int token) {
+    switch(token){
+        case INT: return INT_TYPE;
+        case BYTE: return BYTE_TYPE;
+        case BOOL: return BOOL_TYPE;
+        default: return VOID_TYPE;
+    }
+}
+
+}
+
+// a function definition in the token stream: [begin, end) holds it from OVERRIDE or its return type to its
+// closing brace, its header is parsed ahead for the declaration pass
+struct Compiler::FuncSlice {
+    size_t begin;
+    size_t end;
+    int strings_before; // string literals of the functions ahead of it
+    bool is_override;
+    Type ret_type;
+    NameId name;
+    vector<pair<Type, size_t>> args; // type and token of the name
+};
+
+struct Compiler::FuncResult {
+    bool ok;
+    string diagnostics;
+    string code;
+    IRStrings strings;
+    CompileStats stats;
+};
+
+// the signatures collected by the declaration pass, by name in declaration order
+class Compiler::DeclaredFuncs {
+    struct Func {
+        int order;
+        Type ret_type;
+        vector<Type> arg_types;
+        bool is_override;
+        int func_idx;
+    };
+    unordered_map<string, vector<Func>> funcs;
+public:
+    void add(const string& name, int order, Type ret_type, const vector<Type>& arg_types, bool is_override, int func_idx) {
+        funcs[name].push_back(Func{order, ret_type, arg_types, is_override, func_idx});
+    }
+
+    //appends the signatures of the functions called name declared ahead of the function at order to key
+    void describe(const string& name, int order, string& key) const {
+        auto it = funcs.find(name);
+        if(it == funcs.end()){
+            return;
+        }
+        for(const Func& func: it->second){
+            if(func.order >= order){
+                break;
+            }
+            key += name + " " + to_string(func.ret_type) + "(";
+            for(Type arg_type: func.arg_types){
+                key += to_string(arg_type) + ",";
+            }
+            key += ") " + to_string(func.is_override) + " " + to_string(func.func_idx) + "\n";
+        }
+    }
+
+    //the functions called name declared ahead of the function at order, as entries of its symbol table
+    vector<SymTableEntry*> find(NameId name, int order) const {
+        vector<SymTableEntry*> entries;
+        auto it = funcs.find(NamePool::instance().str(name));
+        if(it == funcs.end()){
+            return entries;
+        }
+        for(const Func& func: it->second){
+            if(func.order >= order){
+                break;
+            }
+            entries.push_back(new SymTableEntry(0, name, 0, func.ret_type, func.arg_types, true,
+                                                func.is_override, func.func_idx, nullptr));
+        }
+        return entries;
+    }
+
+    // the functions a function compiled on its own sees: the ones declared ahead of it
+    class Preceding : public OuterFuncs {
+        const DeclaredFuncs& declared;
+        int order;
+    public:
+        Preceding(const DeclaredFuncs& declared, int order) : declared(declared), order(order) {}
+        vector<SymTableEntry*> find(NameId name) override {
+            return declared.find(name, order);
+        }
+    };
+};
+
+void abortCompilation() {
+    throw CompileError();
+}
+
+Compiler::Compiler(ostream& diagnostics) : names(), arena(), stats(), code(stats), diagnostics(&diagnostics), cache(nullptr), scanner(nullptr),
+        fast_scanner(nullptr), prev(current_compiler), prev_diagnostics(output::redirect(&diagnostics)), whole_program(true),
+        replaying(false), replay_next(nullptr), replay_end(nullptr), replay_names(nullptr), replay_line(0),
+        end_line(0), symbol_table(nullptr), last_exp(VOID_TYPE), in_while(), last_ret_type(VOID_TYPE) {
+    current_compiler = this;
+}
+
+Compiler::~Compiler() {
+    delete symbol_table;
+    current_compiler = prev;
+    output::redirect(prev_diagnostics);
+}
+
+Compiler& Compiler::current() {
+    return *current_compiler;
+}
+
+NamePool& Compiler::namePool() {
+    return names;
+}
+
+Arena& Compiler::codeArena() {
+    return arena;
+}
+
+CodeBuffer& Compiler::codeBuffer() {
+    return code;
+}
+
+CompileStats& Compiler::compileStats() {
+    return stats;
+}
+
+void Compiler::resetSymTable() {
+    delete symbol_table;
+    symbol_table = new SymTable(stats);
+    vector<NameId> predefined_func = {names.intern("print"), names.intern("printi")};
+    initSymTable(symbol_table, predefined_func);
+}
+
+void Compiler::openScanner(FILE* in) {
+    fast_scanner = FastScanner::open(in);
+    if(!fast_scanner){
+        yylex_init(&scanner);
+        yyset_in(in, scanner);
+    }
+}
+
+void Compiler::closeScanner() {
+    if(fast_scanner){
+        delete fast_scanner;
+        fast_scanner = nullptr;
+    } else {
+        yylex_destroy(scanner);
+        scanner = nullptr;
+    }
+}
+
+int Compiler::scan(YYSTYPE* lval) {
+    return fast_scanner ? fast_scanner->scan(lval) : scanToken(lval, scanner);
+}
+
+int Compiler::scannerLine() const {
+    return fast_scanner ? fast_scanner->lineno() : yyget_lineno(scanner);
+}
+
+void Compiler::replay(const Token* begin, const Token* end, const NamePool* token_names, int after_line) {
+    replaying = true;
+    replay_next = begin;
+    replay_end = end;
+    replay_names = token_names;
+    end_line = after_line;
+}
+
+bool Compiler::runParser() {
+    double nested_before = stats.scan_time + stats.optimize_time + stats.print_time;
+    bool ok = true;
+    {
+        PhaseTimer timer(stats, stats.parse_time);
+        try {
+            yyparse(*this);
+        } catch(const CompileError&) {
+            ok = false;
+        }
+    }
+    // the phases timed while parsing are not parse time
+    stats.parse_time -= stats.scan_time + stats.optimize_time + stats.print_time - nested_before;
+    return ok;
+}
+
+void Compiler::setCache(const FuncCache* func_cache) {
+    cache = func_cache;
+}
+
+bool Compiler::parse(FILE* in, int num_threads) {
+    resetSymTable();
+    if(num_threads <= 1 && !cache){
+        openScanner(in);
+        bool ok = runParser();
+        closeScanner();
+        return ok;
+    }
+
+    vector<Token> tokens;
+    int eof_line = readTokens(in, tokens);
+    bool ok;
+    if(parseFunctions(tokens, eof_line, num_threads, ok)){
+        return ok;
+    }
+    // a program that doesn't split into functions is parsed in a single pass, for its diagnostic
+    resetSymTable();
+    replay(tokens.data(), tokens.data() + tokens.size(), &names, eof_line);
+    return runParser();
+}
+
+int Compiler::readTokens(FILE* in, vector<Token>& tokens) {
+    // the message of a lexical error is printed when the parser gets to it
+    ostringstream discarded;
+    ostream* prev_out = output::redirect(&discarded);
+    PhaseTimer timer(stats, stats.scan_time);
+    openScanner(in);
+    YYSTYPE lval;
+    try {
+        while(int token = scan(&lval)){
+            int value = 0;
+            if(token == ID){
+                value = lval.id_name;
+            } else if(token == STRING){
+                value = lval.string_val;
+            } else if(token == NUM){
+                value = lval.int_val;
+            }
+            tokens.push_back(Token{token, value, scannerLine()});
+        }
+    } catch(const CompileError&) {
+        tokens.push_back(Token{LEXICAL_ERROR, 0, scannerLine()});
+    }
+    stats.tokens += long(tokens.size());
+    int eof_line = scannerLine();
+    closeScanner();
+    output::redirect(prev_out);
+    return eof_line;
+}
+
+bool Compiler::parseFunctions(const vector<Token>& tokens, int eof_line, int num_threads, bool& ok) {
+    // split the tokens into function definitions by their headers and braces
+    vector<FuncSlice> slices;
+    size_t pos = 0;
+    int strings = 0;
+    auto expect = [&](int code){
+        return pos < tokens.size() && tokens[pos].code == code;
+    };
+    while(pos < tokens.size()){
+        FuncSlice slice;
+        slice.begin = pos;
+        slice.strings_before = strings;
+        slice.is_override = expect(OVERRIDE);
+        if(slice.is_override){
+            pos++;
+        }
+        if(pos == tokens.size() || (!isType(tokens[pos].code) && tokens[pos].code != VOID)){
+            return false;
+        }
+        slice.ret_type = tokenType(tokens[pos++].code);
+        if(!expect(ID)){
+            return false;
+        }
+        slice.name = tokens[pos++].value;
+        if(!expect(LPAREN)){
+            return false;
+        }
+        pos++;
+        while(!expect(RPAREN)){
+            if(!slice.args.empty()){
+                if(!expect(COMMA)){
+                    return false;
+                }
+                pos++;
+            }
+            if(pos == tokens.size() || !isType(tokens[pos].code) || pos + 1 == tokens.size() || tokens[pos + 1].code != ID){
+                return false;
+            }
+            slice.args.push_back({tokenType(tokens[pos].code), pos + 1});
+            pos += 2;
+        }
+        pos++;
+        if(!expect(LBRACE)){
+            return false;
+        }
+        int depth = 0;
+        do {
+            if(pos == tokens.size() || tokens[pos].code == LEXICAL_ERROR){
+                return false;
+            }
+            int code = tokens[pos++].code;
+            depth += code == LBRACE ? 1 : code == RBRACE ? -1 : 0;
+            strings += code == STRING;
+        } while(depth > 0);
+        slice.end = pos;
+        slices.push_back(slice);
+    }
+    if(slices.empty()){
+        return false;
+    }
+
+    // declaration pass: each function's signature, as addFunc sees it in a single pass. the first header
+    // with an error ends the program, its diagnostic comes from compiling that function
+    DeclaredFuncs declared;
+    size_t num_funcs = slices.size();
+    bool header_error = false;
+    ostringstream discarded;
+    ostream* prev_out = output::redirect(&discarded);
+    CompileStats::Clock::time_point declare_start = CompileStats::Clock::now();
+    replaying = true;
+    for(size_t k = 0; k < slices.size(); k++){
+        const FuncSlice& slice = slices[k];
+        ArgList* args = nullptr;
+        vector<Type> arg_types;
+        for(auto& arg: slice.args){
+            if(!args){
+                args = new ArgList;
+            }
+            ArgInfo* info = new ArgInfo();
+            info->arg_name = tokens[arg.second].value;
+            info->arg_type = arg.first;
+            info->arg_line = tokens[arg.second].line;
+            args->push_back(info);
+            arg_types.push_back(arg.first);
+        }
+        replay_line = tokens[slice.begin].line;
+        try {
+            int func_idx = addFunc(symbol_table, slice.name, slice.ret_type, args, slice.is_override);
+            declared.add(names.str(slice.name), int(k), slice.ret_type, arg_types, slice.is_override, func_idx);
+        } catch(const CompileError&) {
+            num_funcs = k + 1;
+            header_error = true;
+            break;
+        }
+    }
+    if(stats.timed){
+        stats.parse_time += secondsSince(declare_start);
+    }
+    output::redirect(prev_out);
+
+    vector<FuncResult> results(num_funcs);
+    {
+        ThreadPool pool(num_threads);
+        for(size_t k = 0; k < num_funcs; k++){
+            pool.submit([this, &tokens, eof_line, &slices, &declared, &results, k]{
+                compileFunction(tokens, eof_line, slices[k], int(k), declared, results[k]);
+            });
+        }
+        pool.wait();
+    }
+    for(auto& result: results){
+        stats.add(result.stats);
+    }
+
+    for(auto& result: results){
+        if(!result.ok){
+            *diagnostics << result.diagnostics;
+            diagnostics->flush();
+            ok = false;
+            return true;
+        }
+    }
+    if(header_error){
+        return false; // not expected: the function's own compilation reports its header
+    }
+
+    replay_line = eof_line;
+    try {
+        checkMain(symbol_table);
+    } catch(const CompileError&) {
+        ok = false;
+        return true;
+    }
+    for(auto& result: results){
+        code.appendPrinted(result.code, result.strings);
+    }
+    ok = true;
+    return true;
+}
+
+string Compiler::functionKey(const vector<Token>& tokens, const FuncSlice& slice, int order,
+                             const DeclaredFuncs& declared) const {
+    string key = "v" + to_string(CODEGEN_VERSION) + (code.optimize ? " O1" : " O0") + (code.asm_output ? " asm\n" : " ll\n");
+    // the tokens without their lines, which only show in diagnostics
+    vector<NameId> mentioned;
+    unordered_set<NameId> seen;
+    for(size_t i = slice.begin; i < slice.end; i++){
+        const Token& token = tokens[i];
+        key += to_string(token.code);
+        if(token.code == ID || token.code == STRING){
+            const string& name = names.str(token.value);
+            key += " " + to_string(name.size()) + ":" + name;
+            if(token.code == ID && seen.insert(token.value).second){
+                mentioned.push_back(token.value);
+            }
+        } else if(token.code == NUM){
+            key += " " + to_string(token.value);
+        }
+        key += "\n";
+    }
+    // the overloads checkIfLegalCall picks from (and addFunc numbers the function by), for every name used
+    for(NameId name: mentioned){
+        declared.describe(names.str(name), order, key);
+    }
+    return key;
+}
+
+void Compiler::compileFunction(const vector<Token>& tokens, int eof_line, const FuncSlice& slice, int order,
+                               const DeclaredFuncs& declared, FuncResult& result) const {
+    string key;
+    if(cache){
+        key = functionKey(tokens, slice, order, declared);
+        if(cache->load(key, result.code, result.strings)){
+            result.ok = true;
+            result.code = FuncCache::rebaseStrings(result.code, slice.strings_before);
+            result.strings.first = slice.strings_before;
+            return;
+        }
+    }
+
+    // a function going to the cache is compiled with its strings numbered from 0
+    int strings_base = cache ? 0 : slice.strings_before;
+    ostringstream diag;
+    ostringstream func_code;
+    {
+        Compiler function(diag);
+        function.whole_program = false;
+        function.code.setOptimize(code.optimize);
+        function.code.setAsmOutput(code.asm_output);
+        function.code.streamTo(func_code, false);
+        function.code.setStringBase(strings_base);
+        function.stats.timed = stats.timed;
+
+        function.resetSymTable();
+        DeclaredFuncs::Preceding outer(declared, order);
+        function.symbol_table->setOuterFuncs(&outer);
+        int after_line = slice.end < tokens.size() ? tokens[slice.end].line : eof_line;
+        function.replay(tokens.data() + slice.begin, tokens.data() + slice.end, &names, after_line);
+        result.ok = function.runParser();
+        result.strings = function.code.stringLiterals();
+        result.stats = function.stats;
+    }
+    result.diagnostics = diag.str();
+    result.code = func_code.str();
+    if(cache && result.ok){
+        cache->store(key, result.code, result.strings);
+        result.code = FuncCache::rebaseStrings(result.code, slice.strings_before);
+        result.strings.first = slice.strings_before;
+    }
+}
+
+int Compiler::nextToken(YYSTYPE* lval) {
+    if(!replaying){
+        PhaseTimer timer(stats, stats.scan_time);
+        int token = scan(lval);
+        stats.tokens += token != 0;
+        return token;
+    }
+    if(replay_next == replay_end){
+        replay_line = end_line;
+        return 0;
+    }
+    const Token& token = *replay_next++;
+    replay_line = token.line;
+    switch(token.code){
+        case LEXICAL_ERROR:
+            output::errorLex(token.line);
+            abortCompilation();
+        case ID:
+            lval->id_name = replay_names == &names ? token.value : names.intern(replay_names->str(token.value));
+            break;
+        case STRING:
+            lval->string_val = replay_names == &names ? token.value : names.intern(replay_names->str(token.value));
+            break;
+        case NUM:
+            lval->int_val = token.value;
+            break;
+    }
+    return token.code;
+}
+
+bool Compiler::wholeProgram() const {
+    return whole_program;
+}
+
+int Compiler::lineno() const {
+    return replaying ? replay_line : scannerLine();
+}
+
+namespace {
+
+string outputPath(const string& input, bool emit_asm) {
+    size_t dot = input.rfind('.');
+    size_t slash = input.rfind('/');
+    string stem = dot == string::npos || (slash != string::npos && dot < slash) ? input : input.substr(0, dot);
+    return stem + (emit_asm ? ".s" : ".ll");
+}
+
+bool compileFile(const string& input, const CompileOptions& options, const FuncCache* cache, CompileStats& stats) {
+    FILE* in = fopen(input.c_str(), "r");
+    if(!in){
+        cerr << input << ": cannot open" << endl;
+        return false;
+    }
+    string output_path = outputPath(input, options.emit_asm);
+    int fd = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        cerr << output_path << ": cannot create" << endl;
+        fclose(in);
+        return false;
+    }
+
+    OutWriter writer(fd);
+    ostream out(&writer);
+    bool compiled = compileProgram(in, out, options, cache, &stats);
+    fclose(in);
+    bool written = writer.flush();
+    stats.bytes_output += long(writer.bytesWritten());
+    written &= close(fd) == 0;
+    if(!written){
+        cerr << output_path << ": write failed" << endl;
+    }
+    // the diagnostic is in the output file, stderr only names the input
+    if(!compiled){
+        cerr << input << ": compile error" << endl;
+    }
+    return compiled && written;
+}
+
+}
+
+bool compileProgram(FILE* in, ostream& out, const CompileOptions& options, const FuncCache* cache,
+                    CompileStats* stats) {
+    Compiler compiler(out);
+    compiler.codeBuffer().setOptimize(options.optimize);
+    compiler.codeBuffer().setAsmOutput(options.emit_asm);
+    compiler.setCache(cache);
+    compiler.compileStats().timed = stats && stats->timed;
+    initCodeBuff();
+    bool ok = compiler.parse(in);
+    if(ok){
+        printCodeBuff(out);
+    }
+    if(stats){
+        stats->add(compiler.compileStats());
+    }
+    return ok;
+}
+
+bool compileFiles(const vector<string>& files, int num_threads, const CompileOptions& options,
+                  CompileStats* stats) {
+    vector<char> results(files.size(), false);
+    vector<CompileStats> file_stats(files.size());
+    for(auto& file: file_stats){
+        file.timed = stats && stats->timed;
+    }
+    unique_ptr<FuncCache> cache(options.cache_dir.empty() ? nullptr : new FuncCache(options.cache_dir));
+    {
+        ThreadPool pool(num_threads);
+        for(size_t i = 0; i < files.size(); i++){
+            pool.submit([&files, &results, &file_stats, &options, &cache, i]{
+                results[i] = compileFile(files[i], options, cache.get(), file_stats[i]);
+            });
+        }
+        pool.wait();
+    }
+    if(stats){
+        for(auto& file: file_stats){
+            stats->add(file);
+        }
+    }
+    for(char ok: results){
+        if(!ok){
+            return false;
+        }
+    }
+    return true;
+}
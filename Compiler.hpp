@@ -0,0 +1,149 @@
+#ifndef HW5_COMPILER_H
+#define HW5_COMPILER_H
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "SymTable.hpp"
+#include "FuncCache.hpp"
+#include "CompileStats.hpp"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+using namespace std;
+
+union YYSTYPE;
+class FastScanner;
+
+// a token read ahead of the parse: value is the NameId of an ID or a STRING, or the value of a NUM
+struct Token {
+    int code;
+    int value;
+    int line;
+};
+
+// thrown once a diagnostic was printed, unwinds the parser back to Compiler::parse
+struct CompileError {};
+
+//prints nothing itself: the caller already reported the error through output::
+[[noreturn]] void abortCompilation();
+
+// everything a single compilation owns: the string pool, the arena, the code buffer, the symbol table,
+// the grammar's state and the reentrant scanner. the singletons' instance() resolve to the context
+// current on the calling thread, so independent contexts can compile on separate threads.
+// a context becomes current on construction, and the previous one is restored on destruction
+class Compiler {
+    struct FuncSlice;
+    struct FuncResult;
+    class DeclaredFuncs;
+
+    NamePool names;
+    Arena arena;
+    CompileStats stats;
+    CodeBuffer code;
+    ostream* diagnostics;
+    const FuncCache* cache;
+    yyscan_t scanner;
+    FastScanner* fast_scanner; // scans instead of the flex scanner when the input could be mapped
+    Compiler* prev;
+    ostream* prev_diagnostics;
+    bool whole_program;
+
+    // tokens fed to the parser instead of the scanner's, their names are in replay_names
+    bool replaying;
+    const Token* replay_next;
+    const Token* replay_end;
+    const NamePool* replay_names;
+    int replay_line;
+    int end_line; // line of the scanner once it read past the replayed tokens
+
+    Compiler(Compiler const&);
+    void operator=(Compiler const&);
+
+    void resetSymTable();
+    //starts scanning in, with the fast scanner if in can be mapped
+    void openScanner(FILE* in);
+    void closeScanner();
+    int scan(YYSTYPE* lval);
+    int scannerLine() const;
+    void replay(const Token* begin, const Token* end, const NamePool* token_names, int after_line);
+    bool runParser();
+    //scans all of in, a lexical error ends the tokens with a token of its own. returns the line at the end
+    int readTokens(FILE* in, vector<Token>& tokens);
+    //the two-phase parse, returns false when the tokens don't split into function definitions
+    bool parseFunctions(const vector<Token>& tokens, int eof_line, int num_threads, bool& ok);
+    //everything the code of a function depends on, the key of its cache entry
+    string functionKey(const vector<Token>& tokens, const FuncSlice& slice, int order, const DeclaredFuncs& declared) const;
+    //compiles the function of slice, the order-th of the program, in a context of its own
+    void compileFunction(const vector<Token>& tokens, int eof_line, const FuncSlice& slice, int order,
+                         const DeclaredFuncs& declared, FuncResult& result) const;
+public:
+    // state of the grammar actions
+    SymTable* symbol_table;
+    Type last_exp;
+    vector<bool> in_while;
+    Type last_ret_type;
+
+    //diagnostics of this compilation are printed to diagnostics
+    explicit Compiler(ostream& diagnostics);
+    ~Compiler();
+
+    static Compiler& current();
+
+    NamePool& namePool();
+    Arena& codeArena();
+    CodeBuffer& codeBuffer();
+    //the counters of this compilation, set timed before parsing to time its phases as well
+    CompileStats& compileStats();
+
+    //parses the program read from in, generating its code to the code buffer.
+    //returns false if an error was reported, the code buffer then holds a partial program.
+    //with more than one thread, the program is read in two phases: the signatures of all of its
+    //functions are declared first, then the functions are compiled in parallel, each in a context of
+    //its own that sees the functions declared ahead of it. their code is appended in program order,
+    //and the first error in program order is the one reported, as in a single pass
+    bool parse(FILE* in, int num_threads = 1);
+
+    //reuse the code of functions compiled before from func_cache, and add the ones compiled now to it.
+    //the program is then always parsed in two phases, to look up each of its functions
+    void setCache(const FuncCache* func_cache);
+
+    //the next token for the parser
+    int nextToken(YYSTYPE* lval);
+    //called by the parser on every reduction
+    void countReduction() { stats.reductions++; }
+
+    //false while compiling a single function of a program split by the two-phase parse
+    bool wholeProgram() const;
+
+    //line of the scanner, for diagnostics
+    int lineno() const;
+};
+
+//settings applied to the code buffer of every compilation
+struct CompileOptions {
+    bool optimize;
+    bool emit_asm;
+    string cache_dir; // empty for no function cache
+
+    CompileOptions() : optimize(true), emit_asm(false), cache_dir() {}
+};
+
+//compiles the program read from in in a context of its own, printing its code to out, or its diagnostic
+//(and false) if it has an error. the counters of the compilation are added to stats, if given
+bool compileProgram(FILE* in, ostream& out, const CompileOptions& options, const FuncCache* cache = nullptr,
+                    CompileStats* stats = nullptr);
+
+//compiles each file to a file next to it, with its extension replaced by .ll (.s for emit_asm).
+//the files are spread over a work-stealing pool of num_threads threads. a program with an error gets
+//its diagnostic written instead of its code, and its name reported on stderr. returns false if a program
+//had an error or a file couldn't be read or written.
+//the counters of all the compilations are added to stats, if given
+bool compileFiles(const vector<string>& files, int num_threads, const CompileOptions& options,
+                  CompileStats* stats = nullptr);
+
+#endif //HW5_COMPILER_H
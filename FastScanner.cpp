@@ -0,0 +1,261 @@
+#include "FastScanner.hpp"
+#include "attributes.h"
+#include "hw3_output.hpp"
+#include "parser.tab.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// character classes of the scanner, a table lookup each
+enum CharClass : unsigned char {
+    CHAR_OTHER = 0,
+    CHAR_LETTER = 1,
+    CHAR_DIGIT = 2,
+    CHAR_BLANK = 4,
+};
+
+struct CharClasses {
+    unsigned char of[256];
+
+    CharClasses() {
+        memset(of, CHAR_OTHER, sizeof(of));
+        for(int c = 'a'; c <= 'z'; c++){
+            of[c] = of[c - 'a' + 'A'] = CHAR_LETTER;
+        }
+        for(int c = '0'; c <= '9'; c++){
+            of[c] = CHAR_DIGIT;
+        }
+        of[int(' ')] = of[int('\t')] = of[int('\n')] = of[int('\r')] = CHAR_BLANK;
+    }
+};
+
+const CharClasses char_classes;
+
+unsigned char classOf(char c) {
+    return char_classes.of[(unsigned char)c];
+}
+
+// keywords by a perfect hash: the sum of their first and last characters, mod 32, differs for all of them
+const size_t KEYWORD_SLOTS = 32;
+const size_t MAX_KEYWORD_LEN = 8;
+
+struct Keywords {
+    const char* word[KEYWORD_SLOTS];
+    int token[KEYWORD_SLOTS];
+
+    static size_t slot(const char* text, size_t len) {
+        return ((unsigned char)text[0] + (unsigned char)text[len - 1]) % KEYWORD_SLOTS;
+    }
+
+    Keywords() : word(), token() {
+        static const struct { const char* word; int token; } all[] = {
+            {"void", VOID}, {"int", INT}, {"byte", BYTE}, {"b", B}, {"bool", BOOL}, {"override", OVERRIDE},
+            {"and", AND}, {"or", OR}, {"not", NOT}, {"true", TRUE}, {"false", FALSE}, {"return", RETURN},
+            {"if", IF}, {"else", ELSE}, {"while", WHILE}, {"break", BREAK}, {"continue", CONTINUE},
+        };
+        for(auto& keyword: all){
+            size_t at = slot(keyword.word, strlen(keyword.word));
+            word[at] = keyword.word;
+            token[at] = keyword.token;
+        }
+    }
+
+    //the token of the keyword text is, 0 for an identifier
+    int find(const char* text, size_t len) const {
+        if(len > MAX_KEYWORD_LEN){
+            return 0;
+        }
+        size_t at = slot(text, len);
+        return word[at] && strlen(word[at]) == len && memcmp(word[at], text, len) == 0 ? token[at] : 0;
+    }
+};
+
+const Keywords keywords;
+
+[[noreturn]] void lexicalError(int line) {
+    output::errorLex(line);
+    abortCompilation();
+}
+
+}
+
+FastScanner::FastScanner(const char* begin, const char* end, void* mapped, size_t mapped_len)
+        : pos(begin), end(end), mapped(mapped), mapped_len(mapped_len), line(1) {}
+
+FastScanner* FastScanner::open(FILE* in) {
+    int fd = fileno(in);
+    struct stat info;
+    if(fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+        return nullptr;
+    }
+    // whatever stdio read ahead of the scanner is skipped in the mapping too
+    off_t offset = ftello(in);
+    if(offset < 0 || offset > info.st_size){
+        return nullptr;
+    }
+    size_t len = size_t(info.st_size);
+    if(len == 0 || size_t(offset) == len){
+        return new FastScanner(nullptr, nullptr, nullptr, 0);
+    }
+    void* mapped = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapped == MAP_FAILED){
+        return nullptr;
+    }
+    madvise(mapped, len, MADV_SEQUENTIAL);
+    const char* data = static_cast<const char*>(mapped);
+    return new FastScanner(data + offset, data + len, mapped, len);
+}
+
+FastScanner::~FastScanner() {
+    if(mapped){
+        munmap(mapped, mapped_len);
+    }
+}
+
+void FastScanner::skipBlanks() {
+    for(;;){
+#ifdef __SSE2__
+        // the blanks 16 at a time, counting the newlines among them
+        while(end - pos >= 16){
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+            __m128i newline = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+            __m128i blank = _mm_or_si128(_mm_or_si128(newline, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '))),
+                                         _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')),
+                                                      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+            unsigned newlines = unsigned(_mm_movemask_epi8(newline));
+            unsigned others = ~unsigned(_mm_movemask_epi8(blank)) & 0xffff;
+            if(others){
+                int skipped = __builtin_ctz(others);
+                line += __builtin_popcount(newlines & ((1u << skipped) - 1));
+                pos += skipped;
+                break;
+            }
+            line += __builtin_popcount(newlines);
+            pos += 16;
+        }
+#endif
+        while(pos < end && classOf(*pos) == CHAR_BLANK){
+            line += *pos++ == '\n';
+        }
+        if(end - pos < 2 || pos[0] != '/' || pos[1] != '/'){
+            return;
+        }
+
+        // a comment runs to the end of its line, and takes the \r or \n ending it
+        pos += 2;
+#ifdef __SSE2__
+        while(end - pos >= 16){
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+            unsigned line_end = unsigned(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')),
+                                                                        _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')))));
+            if(line_end){
+                pos += __builtin_ctz(line_end);
+                break;
+            }
+            pos += 16;
+        }
+#endif
+        while(pos < end && *pos != '\n' && *pos != '\r'){
+            pos++;
+        }
+        if(pos < end){
+            line += *pos++ == '\n';
+        }
+    }
+}
+
+int FastScanner::scan(YYSTYPE* lval) {
+    skipBlanks();
+    if(pos == end){
+        return 0;
+    }
+
+    const char* start = pos;
+    unsigned char kind = classOf(*pos);
+    if(kind == CHAR_LETTER){
+        while(++pos < end && (classOf(*pos) & (CHAR_LETTER | CHAR_DIGIT))){
+        }
+        size_t len = size_t(pos - start);
+        if(int token = keywords.find(start, len)){
+            return token;
+        }
+        lval->id_name = NamePool::instance().intern(start, len);
+        return ID;
+    }
+    if(kind == CHAR_DIGIT){
+        // a number doesn't start with 0 unless it is 0, "012" is the numbers 0 and 12
+        if(*pos++ != '0'){
+            while(pos < end && classOf(*pos) == CHAR_DIGIT){
+                pos++;
+            }
+        }
+        lval->int_val = atoi(string(start, pos).c_str());
+        return NUM;
+    }
+
+    switch(*pos++){
+        case ';': return SC;
+        case ',': return COMMA;
+        case '(': return LPAREN;
+        case ')': return RPAREN;
+        case '{': return LBRACE;
+        case '}': return RBRACE;
+        case '+': return PLUS;
+        case '*': return MUL;
+        case '-': return MINUS;
+        case '/': return DIV;
+        case '=':
+            if(pos < end && *pos == '='){
+                pos++;
+                return EQUAL;
+            }
+            return ASSIGN;
+        case '!':
+            if(pos < end && *pos == '='){
+                pos++;
+                return NOT_EQUAL;
+            }
+            break;
+        case '<':
+            if(pos < end && *pos == '='){
+                pos++;
+                return LESS_EQUAL;
+            }
+            return LESS;
+        case '>':
+            if(pos < end && *pos == '='){
+                pos++;
+                return GREATER_EQUAL;
+            }
+            return GREATER;
+        case '"': {
+            // at least one character, on a single line, with only the escapes \r \n \t \" and \\ .
+            // anything else leaves the quote itself as the error, like the flex rules
+            const char* text = pos;
+            while(text < end && *text != '"' && *text != '\n' && *text != '\r'){
+                if(*text == '\\'){
+                    if(end - text < 2 || !strchr("rnt\"\\", text[1]) || text[1] == '\0'){
+                        lexicalError(line);
+                    }
+                    text++;
+                }
+                text++;
+            }
+            if(text == end || *text != '"' || text == pos){
+                lexicalError(line);
+            }
+            pos = text + 1;
+            lval->string_val = NamePool::instance().intern(start, size_t(pos - start));
+            return STRING;
+        }
+    }
+    lexicalError(line);
+}
@@ -0,0 +1,40 @@
+#ifndef HW5_FAST_SCANNER_H
+#define HW5_FAST_SCANNER_H
+
+#include <cstddef>
+#include <cstdio>
+
+using namespace std;
+
+union YYSTYPE;
+
+// scanner of an input held in memory, the fast path for inputs that are regular files: the file is
+// mapped instead of read through stdio, whitespace and comments are skipped 16 bytes at a time with
+// SSE2, and keywords are told apart from identifiers by a perfect hash instead of the states of a DFA.
+// its tokens, their values, its lexical errors and its line numbers are those of scanner.lex
+class FastScanner {
+    const char* pos;
+    const char* end;
+    void* mapped;
+    size_t mapped_len;
+    int line;
+
+    FastScanner(const char* begin, const char* end, void* mapped, size_t mapped_len);
+    FastScanner(FastScanner const&);
+    void operator=(FastScanner const&);
+
+    //skips whitespace and comments up to the next token
+    void skipBlanks();
+public:
+    //maps the rest of in, returns nullptr if it can't be mapped (a pipe, a terminal, a memory stream)
+    static FastScanner* open(FILE* in);
+    ~FastScanner();
+
+    //the next token and its value in lval, 0 at the end of the input. a lexical error is reported at its
+    //line and aborts the compilation
+    int scan(YYSTYPE* lval);
+    //line of the last character read
+    int lineno() const { return line; }
+};
+
+#endif //HW5_FAST_SCANNER_H
@@ -0,0 +1,163 @@
+#include "FuncCache.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const string MAGIC = "hw5-func-cache 1\n";
+
+uint64_t hashKey(const string& key) {
+    // FNV-1a
+    uint64_t h = 14695981039346656037ull;
+    for(unsigned char c: key){
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// fields are stored as their size in decimal, a newline and their bytes
+void putField(string& out, const string& field) {
+    out += to_string(field.size());
+    out += '\n';
+    out += field;
+}
+
+bool getNumber(const string& data, size_t& pos, size_t& num) {
+    size_t end = data.find('\n', pos);
+    if(end == string::npos || end == pos){
+        return false;
+    }
+    num = 0;
+    for(size_t i = pos; i < end; i++){
+        if(data[i] < '0' || data[i] > '9'){
+            return false;
+        }
+        num = num * 10 + size_t(data[i] - '0');
+    }
+    pos = end + 1;
+    return true;
+}
+
+bool getField(const string& data, size_t& pos, string& field) {
+    size_t size;
+    if(!getNumber(data, pos, size) || size > data.size() - pos){
+        return false;
+    }
+    field = data.substr(pos, size);
+    pos += size;
+    return true;
+}
+
+}
+
+FuncCache::FuncCache(const string& dir) : dir(dir) {
+    mkdir(dir.c_str(), 0755); // may exist already
+}
+
+string FuncCache::path(const string& key) const {
+    char name[17];
+    snprintf(name, sizeof(name), "%016llx", (unsigned long long)hashKey(key));
+    return dir + "/" + name;
+}
+
+bool FuncCache::load(const string& key, string& code, IRStrings& strings) const {
+    ifstream in(path(key), ios::binary);
+    if(!in){
+        return false;
+    }
+    stringstream contents;
+    contents << in.rdbuf();
+    string data = contents.str();
+
+    size_t pos = MAGIC.size();
+    string stored_key;
+    size_t num_strings;
+    if(data.compare(0, MAGIC.size(), MAGIC) != 0 || !getField(data, pos, stored_key) || stored_key != key ||
+       !getField(data, pos, code) || !getNumber(data, pos, num_strings)){
+        return false;
+    }
+    strings.literals.clear();
+    strings.lengths.clear();
+    for(size_t i = 0; i < num_strings; i++){
+        size_t length;
+        string literal;
+        if(!getNumber(data, pos, length) || !getField(data, pos, literal)){
+            return false;
+        }
+        strings.lengths.push_back(int(length));
+        strings.literals.push_back(literal);
+    }
+    return pos == data.size();
+}
+
+void FuncCache::store(const string& key, const string& code, const IRStrings& strings) const {
+    string data = MAGIC;
+    putField(data, key);
+    putField(data, code);
+    data += to_string(strings.literals.size()) + '\n';
+    for(size_t i = 0; i < strings.literals.size(); i++){
+        data += to_string(strings.lengths[i]) + '\n';
+        putField(data, strings.literals[i]);
+    }
+
+    // a reader never sees a partly written file
+    static atomic<unsigned> tmp_count(0);
+    string file = path(key);
+    string tmp = file + ".tmp" + to_string(getpid()) + "." + to_string(tmp_count++);
+    {
+        ofstream out(tmp, ios::binary);
+        out.write(data.data(), streamsize(data.size()));
+        if(!out){
+            out.close();
+            unlink(tmp.c_str());
+            return;
+        }
+    }
+    if(rename(tmp.c_str(), file.c_str()) != 0){
+        unlink(tmp.c_str());
+    }
+}
+
+string FuncCache::rebaseStrings(const string& code, int delta) {
+    if(delta == 0){
+        return code;
+    }
+    // the references are "]* @s<i>" in the getelementptr of LLVM IR and "leaq .Ls<i>(" in assembly,
+    // function names can look like string names but never follow these
+    static const char* const prefixes[] = {"]* @s", "leaq .Ls"};
+    string out;
+    out.reserve(code.size() + 64);
+    size_t pos = 0;
+    while(pos < code.size()){
+        size_t next = string::npos;
+        size_t prefix_len = 0;
+        for(const char* prefix: prefixes){
+            size_t found = code.find(prefix, pos);
+            if(found < next){
+                next = found;
+                prefix_len = strlen(prefix);
+            }
+        }
+        if(next == string::npos){
+            out.append(code, pos, string::npos);
+            break;
+        }
+        size_t digits = next + prefix_len;
+        size_t end = digits;
+        while(end < code.size() && code[end] >= '0' && code[end] <= '9'){
+            end++;
+        }
+        out.append(code, pos, digits - pos);
+        if(end > digits){
+            out += to_string(stoi(code.substr(digits, end - digits)) + delta);
+        }
+        pos = end;
+    }
+    return out;
+}
@@ -0,0 +1,29 @@
+#ifndef HW5_FUNC_CACHE_H
+#define HW5_FUNC_CACHE_H
+
+#include <string>
+#include "IR.hpp"
+
+using namespace std;
+
+// on-disk cache of compiled functions, one file per function named by the hash of its key.
+// the key holds everything the function's code depends on (its tokens, the signatures of the functions
+// it can call, the compiler build and options), and is stored in the file and compared in full on a hit.
+// functions are cached with their string literals numbered from 0.
+// files are written to a temporary name and renamed, so processes can share a directory
+class FuncCache {
+    string dir;
+
+    string path(const string& key) const;
+public:
+    explicit FuncCache(const string& dir);
+
+    //on a hit, sets the printed code and the string literals of the function cached under key
+    bool load(const string& key, string& code, IRStrings& strings) const;
+    void store(const string& key, const string& code, const IRStrings& strings) const;
+
+    //renumbers the string literals referenced by printed code (LLVM IR or assembly) by delta
+    static string rebaseStrings(const string& code, int delta);
+};
+
+#endif //HW5_FUNC_CACHE_H
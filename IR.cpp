@@ -0,0 +1,183 @@
+#include "IR.hpp"
+
+static const char* icmpPredStr(ICmpPred pred){
+    static const char* preds[] = {"eq", "ne", "slt", "sle", "sgt", "sge"};
+    return preds[pred];
+}
+
+static const char* binopStr(Opcode op){
+    switch(op){
+        case OP_ADD: return "add";
+        case OP_SUB: return "sub";
+        case OP_MUL: return "mul";
+        case OP_SDIV: return "sdiv";
+        case OP_UDIV: return "udiv";
+        case OP_AND: return "and";
+        case OP_OR: return "or";
+        default: return "xor";
+    }
+}
+
+const char* irTypeStr(IRType type){
+    static const char* types[] = {"void", "i1", "i8", "i32", "i8*", "i32*", "i1*"};
+    return types[type];
+}
+
+IRType pointerTo(IRType type){
+    return type == IR_I1 ? IR_I1_PTR : type == IR_I8 ? IR_I8_PTR : IR_I32_PTR;
+}
+
+static void printLabel(ostream& os, int block){
+    if(block < 0){
+        os << "@"; // not backpatched yet
+    } else {
+        os << "%label_" << block;
+    }
+}
+
+void printOperand(ostream& os, const Operand& opnd){
+    switch(opnd.kind){
+        case OPND_VALUE: os << "%t" << opnd.id; break;
+        case OPND_CONST: os << opnd.id; break;
+        case OPND_ARG: os << "%arg" << opnd.id; break;
+        case OPND_LABEL: printLabel(os, opnd.id); break;
+        case OPND_FUNC: os << "@" << NamePool::instance().str(opnd.id); break;
+        case OPND_STR: os << "@s" << opnd.id; break;
+        case OPND_NONE: break;
+    }
+}
+
+static void printTypedOperand(ostream& os, const Operand& opnd){
+    os << irTypeStr(opnd.type) << " ";
+    printOperand(os, opnd);
+}
+
+void printInstr(ostream& os, const IRFunction& func, const Instr& instr, const IRStrings& strings){
+    if(instr.dst >= 0){
+        os << "%t" << instr.dst << " = ";
+    }
+
+    switch(instr.op){
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_SDIV:
+        case OP_UDIV:
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR:
+            os << binopStr(instr.op) << " " << irTypeStr(instr.type) << " ";
+            printOperand(os, instr.ops[0]);
+            os << ", ";
+            printOperand(os, instr.ops[1]);
+            break;
+        case OP_ICMP:
+            os << "icmp " << icmpPredStr(instr.pred) << " ";
+            printTypedOperand(os, instr.ops[0]);
+            os << ", ";
+            printOperand(os, instr.ops[1]);
+            break;
+        case OP_ZEXT:
+        case OP_TRUNC:
+            os << (instr.op == OP_ZEXT ? "zext " : "trunc ");
+            printTypedOperand(os, instr.ops[0]);
+            os << " to " << irTypeStr(instr.type);
+            break;
+        case OP_ALLOCA:
+            os << "alloca " << irTypeStr(instr.type) << ", ";
+            printTypedOperand(os, instr.ops[0]);
+            break;
+        case OP_GEP:
+            os << "getelementptr " << irTypeStr(instr.type) << ", ";
+            printTypedOperand(os, instr.ops[0]);
+            os << ", ";
+            printTypedOperand(os, instr.ops[1]);
+            break;
+        case OP_LOAD:
+            os << "load " << irTypeStr(instr.type) << ", ";
+            printTypedOperand(os, instr.ops[0]);
+            break;
+        case OP_STORE:
+            os << "store ";
+            printTypedOperand(os, instr.ops[0]);
+            os << ", ";
+            printTypedOperand(os, instr.ops[1]);
+            break;
+        case OP_STR_PTR: {
+            int len = strings.lengths[instr.ops[0].id - strings.first];
+            os << "getelementptr [" << len << " x i8], [" << len << " x i8]* ";
+            printOperand(os, instr.ops[0]);
+            os << ", i32 0, i32 0";
+            break;
+        }
+        case OP_CALL:
+            os << (instr.tail ? "tail call " : "call ") << irTypeStr(instr.type) << " ";
+            printOperand(os, instr.ops[0]);
+            os << "(";
+            for(int i = 0; i < instr.extra_count; i++){
+                if(i > 0){
+                    os << ", ";
+                }
+                printTypedOperand(os, func.extra[instr.extra_begin + i]);
+            }
+            os << ")";
+            break;
+        case OP_PHI:
+            os << "phi " << irTypeStr(instr.type) << " ";
+            for(int i = 0; i < instr.extra_count; i += 2){
+                if(i > 0){
+                    os << ", ";
+                }
+                os << "[";
+                printOperand(os, func.extra[instr.extra_begin + i]);
+                os << ", ";
+                printOperand(os, func.extra[instr.extra_begin + i + 1]);
+                os << "]";
+            }
+            break;
+        case OP_BR:
+            os << "br label ";
+            printOperand(os, instr.ops[0]);
+            break;
+        case OP_COND_BR:
+            os << "br ";
+            printTypedOperand(os, instr.ops[0]);
+            os << ", label ";
+            printOperand(os, instr.ops[1]);
+            os << ", label ";
+            printOperand(os, instr.ops[2]);
+            break;
+        case OP_RET:
+            if(instr.ops[0].kind == OPND_NONE){
+                os << "ret void";
+            } else {
+                os << "ret ";
+                printTypedOperand(os, instr.ops[0]);
+            }
+            break;
+        case OP_UNREACHABLE:
+            os << "unreachable";
+            break;
+    }
+}
+
+void printFunction(ostream& os, const IRFunction& func, const IRStrings& strings){
+    os << "define " << irTypeStr(func.ret_type) << " @" << NamePool::instance().str(func.name) << "(";
+    for(size_t i = 0; i < func.arg_types.size(); i++){
+        if(i > 0){
+            os << ", ";
+        }
+        os << irTypeStr(func.arg_types[i]) << " %arg" << i + 1;
+    }
+    os << ") {\n";
+
+    for(size_t block = 0; block < func.blocks.size(); block++){
+        // the entry block is labeled too, phis built by the passes may name it as a predecessor
+        os << "label_" << block << ":\n";
+        for(auto& instr: func.blocks[block].instrs){
+            printInstr(os, func, instr, strings);
+            os << "\n";
+        }
+    }
+    os << "}\n";
+}
@@ -0,0 +1,135 @@
+#ifndef HW5_IR_H
+#define HW5_IR_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "NamePool.hpp"
+
+using namespace std;
+
+// typed in-memory representation of the emitted LLVM code, printed as LLVM
+// text only once a function is complete
+
+enum IRType : uint8_t {
+    IR_VOID,
+    IR_I1,
+    IR_I8,
+    IR_I32,
+    IR_I8_PTR,
+    IR_I32_PTR,
+    IR_I1_PTR,
+};
+
+enum OperandKind : uint8_t {
+    OPND_NONE,
+    OPND_VALUE, // id is a value defined in the function
+    OPND_CONST, // id is the constant itself
+    OPND_ARG,   // id is the 1-based index of a function argument
+    OPND_LABEL, // id is a basic block of the function, -1 while not backpatched
+    OPND_FUNC,  // id is the NameId of a (mangled) function name
+    OPND_STR,   // id is the index of a global string literal
+};
+
+struct Operand {
+    OperandKind kind;
+    IRType type;
+    int id;
+
+    Operand() : kind(OPND_NONE), type(IR_VOID), id(0) {}
+    Operand(OperandKind kind, IRType type, int id) : kind(kind), type(type), id(id) {}
+
+    static Operand value(int id, IRType type) { return Operand(OPND_VALUE, type, id); }
+    static Operand constant(int val, IRType type) { return Operand(OPND_CONST, type, val); }
+    static Operand arg(int idx, IRType type) { return Operand(OPND_ARG, type, idx); }
+    static Operand label(int block) { return Operand(OPND_LABEL, IR_VOID, block); }
+    static Operand func(NameId name) { return Operand(OPND_FUNC, IR_VOID, name); }
+    static Operand str(int idx) { return Operand(OPND_STR, IR_I8_PTR, idx); }
+
+    bool operator==(const Operand& other) const { return kind == other.kind && type == other.type && id == other.id; }
+    bool operator!=(const Operand& other) const { return !(*this == other); }
+};
+
+enum Opcode : uint8_t {
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_SDIV,
+    OP_UDIV,
+    OP_AND,         // i1 only, like OP_OR and OP_XOR
+    OP_OR,
+    OP_XOR,
+    OP_ICMP,        // ops: lhs, rhs
+    OP_ZEXT,        // ops: value, type is the target type
+    OP_TRUNC,       // ops: value, type is the target type
+    OP_ALLOCA,      // ops: element count, type is the element type
+    OP_GEP,         // ops: base pointer, index, type is the element type
+    OP_LOAD,        // ops: pointer
+    OP_STORE,       // ops: value, pointer
+    OP_STR_PTR,     // ops: string literal, yields a pointer to its first char
+    OP_CALL,        // ops: callee, args are extra operands
+    OP_PHI,         // extra operands are {value, label} pairs
+    OP_BR,          // ops: label
+    OP_COND_BR,     // ops: condition, true label, false label
+    OP_RET,         // ops: value, or none for ret void
+    OP_UNREACHABLE,
+};
+
+enum ICmpPred : uint8_t {
+    ICMP_EQ,
+    ICMP_NE,
+    ICMP_SLT,
+    ICMP_SLE,
+    ICMP_SGT,
+    ICMP_SGE,
+};
+
+struct Instr {
+    Opcode op;
+    IRType type;    // result type, or the operated type for instructions without a result
+    ICmpPred pred;  // only for OP_ICMP
+    bool tail;      // only for OP_CALL, a call whose result is returned right away
+    int dst;        // value defined by the instruction, -1 if none
+    Operand ops[3];
+    int extra_begin; // call arguments and phi incoming live in IRFunction::extra
+    int extra_count;
+
+    Instr(Opcode op, IRType type, int dst = -1)
+    : op(op), type(type), pred(ICMP_EQ), tail(false), dst(dst), ops(), extra_begin(0), extra_count(0) {}
+
+    bool isTerminator() const { return op == OP_BR || op == OP_COND_BR || op == OP_RET || op == OP_UNREACHABLE; }
+};
+
+struct BasicBlock {
+    vector<Instr> instrs;
+
+    bool terminated() const { return !instrs.empty() && instrs.back().isTerminator(); }
+};
+
+struct IRFunction {
+    NameId name; // mangled name, without the '@'
+    IRType ret_type;
+    vector<IRType> arg_types;
+    vector<BasicBlock> blocks; // blocks[0] is the entry block
+    vector<Operand> extra;
+    int num_values;
+
+    IRFunction() : name(0), ret_type(IR_VOID), arg_types(), blocks(), extra(), num_values(0) {}
+};
+
+// string literals of the data section, in LLVM c"..." syntax without the quotes and the \00
+struct IRStrings {
+    int first = 0; // index of literals[0], nonzero in the buffer of a function compiled on its own
+    vector<string> literals;
+    vector<int> lengths; // array length, including the terminating \00
+};
+
+const char* irTypeStr(IRType type);
+//the type of a pointer to a value of type
+IRType pointerTo(IRType type);
+void printOperand(ostream& os, const Operand& opnd);
+void printInstr(ostream& os, const IRFunction& func, const Instr& instr, const IRStrings& strings);
+void printFunction(ostream& os, const IRFunction& func, const IRStrings& strings);
+
+#endif //HW5_IR_H
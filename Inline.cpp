@@ -0,0 +1,145 @@
+#include "Passes.hpp"
+#include "CFG.hpp"
+
+/* inlining of small functions into their callers. a function can only call the functions defined
+ * ahead of it (and itself), which are closed and optimized by the time its calls are seen, so the
+ * callees are kept already optimized and with their own calls inlined, and one pass over the caller
+ * is enough. the block of a call is split after it, the callee's blocks are copied in between with
+ * its values and labels renumbered and its arguments replaced by the call's (which callAction has
+ * already zero extended to the parameter types), and its returns become branches to the split-off
+ * block, where a phi merges the returned values */
+
+namespace {
+
+// instructions of a callee, not counting phis and branches, beyond which it isn't inlined
+const int MAX_INLINE_SIZE = 40;
+
+//replaces the call ending block (after splitting) by the blocks of callee, returns the result
+Operand inlineCall(IRFunction& func, int block, const Instr& call, const IRFunction& callee, int after){
+    int value_base = func.num_values;
+    int block_base = int(func.blocks.size());
+    func.num_values += callee.num_values;
+
+    vector<Operand> args(func.extra.begin() + call.extra_begin,
+                         func.extra.begin() + call.extra_begin + call.extra_count);
+    auto mapOperand = [&](Operand opnd){
+        if(opnd.kind == OPND_VALUE){
+            opnd.id += value_base;
+        } else if(opnd.kind == OPND_LABEL){
+            opnd.id += block_base;
+        } else if(opnd.kind == OPND_ARG){
+            opnd = args[opnd.id - 1];
+        }
+        return opnd;
+    };
+
+    vector<pair<Operand,int>> returned;
+    for(size_t b = 0; b < callee.blocks.size(); b++){
+        func.blocks.push_back(BasicBlock());
+        BasicBlock& copy = func.blocks.back();
+        for(const Instr& instr: callee.blocks[b].instrs){
+            Instr mapped = instr;
+            if(mapped.dst >= 0){
+                mapped.dst += value_base;
+            }
+            mapped.tail = false; // a tail call of the callee is followed by a branch here
+            for(auto& opnd: mapped.ops){
+                opnd = mapOperand(opnd);
+            }
+            if(instr.extra_count){
+                mapped.extra_begin = int(func.extra.size());
+                for(int i = 0; i < instr.extra_count; i++){
+                    func.extra.push_back(mapOperand(callee.extra[instr.extra_begin + i]));
+                }
+            }
+            if(instr.op == OP_RET){
+                if(instr.ops[0].kind != OPND_NONE){
+                    returned.push_back({mapped.ops[0], block_base + int(b)});
+                }
+                mapped = Instr(OP_BR, IR_VOID);
+                mapped.ops[0] = Operand::label(after);
+            }
+            copy.instrs.push_back(mapped);
+        }
+    }
+
+    Instr br(OP_BR, IR_VOID);
+    br.ops[0] = Operand::label(block_base);
+    func.blocks[block].instrs.push_back(br);
+
+    if(call.dst < 0 || returned.empty()){
+        return Operand();
+    }
+    if(returned.size() == 1){
+        return returned[0].first;
+    }
+    Instr phi(OP_PHI, call.type, func.num_values++);
+    phi.extra_begin = int(func.extra.size());
+    phi.extra_count = 2 * int(returned.size());
+    for(auto& incoming: returned){
+        func.extra.push_back(incoming.first);
+        func.extra.push_back(Operand::label(incoming.second));
+    }
+    auto& instrs = func.blocks[after].instrs;
+    instrs.insert(instrs.begin(), phi);
+    return Operand::value(phi.dst, call.type);
+}
+
+}
+
+bool isInlineCandidate(const IRFunction& func){
+    int size = 0;
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            // a recursive function would only be unrolled once, and an alloca in a loop of the caller
+            // would grow its frame on every iteration
+            if((instr.op == OP_CALL && instr.ops[0].id == func.name) || instr.op == OP_ALLOCA){
+                return false;
+            }
+            if(instr.op != OP_PHI && instr.op != OP_BR){
+                size++;
+            }
+        }
+    }
+    return size <= MAX_INLINE_SIZE;
+}
+
+void inlineCalls(IRFunction& func, const InlineCallees& callees){
+    if(callees.empty()){
+        return;
+    }
+    vector<Operand> subst;
+    // blocks split off and inlined are appended, and scanned in turn
+    for(size_t block = 0; block < func.blocks.size(); block++){
+        for(size_t i = 0; i < func.blocks[block].instrs.size(); i++){
+            Instr call = func.blocks[block].instrs[i];
+            if(call.op != OP_CALL){
+                continue;
+            }
+            auto callee = callees.find(call.ops[0].id);
+            if(callee == callees.end()){
+                continue;
+            }
+
+            // the instructions after the call move to a block of their own, which the successors'
+            // phis now come from
+            int after = int(func.blocks.size());
+            func.blocks.push_back(BasicBlock());
+            auto& instrs = func.blocks[block].instrs;
+            func.blocks[after].instrs.assign(instrs.begin() + i + 1, instrs.end());
+            instrs.erase(instrs.begin() + i, instrs.end());
+            for(int succ: successors(func.blocks[after])){
+                renamePhiEdges(func, succ, int(block), after);
+            }
+
+            Operand result = inlineCall(func, int(block), call, callee->second, after);
+            if(call.dst >= 0){
+                subst.resize(func.num_values, Operand());
+                subst[call.dst] = result.kind != OPND_NONE ? result : Operand::constant(0, call.type);
+            }
+            break;
+        }
+    }
+    subst.resize(func.num_values, Operand());
+    substituteValues(func, subst);
+}
@@ -0,0 +1,104 @@
+#include "JIT.hpp"
+
+#ifdef HW5_WITH_ORC
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace llvm;
+using namespace llvm::orc;
+
+// the runtime of initCodeBuff, as host functions. like it, they format numbers by hand and leave the
+// buffering to stdout, which exit flushes
+static void hostPrinti(int32_t val){
+    char digits[12];
+    char* start = digits + sizeof(digits);
+    *--start = '\n';
+    uint32_t rest = val < 0 ? 0u - uint32_t(val) : uint32_t(val);
+    do {
+        *--start = char('0' + rest % 10);
+        rest /= 10;
+    } while(rest);
+    if(val < 0){
+        *--start = '-';
+    }
+    fwrite(start, 1, digits + sizeof(digits) - start, stdout);
+}
+
+static void hostPrint(const char* str){
+    fputs(str, stdout);
+    putc('\n', stdout);
+}
+
+static void hostDivByZero(){
+    hostPrint("Error division by zero");
+    exit(0);
+}
+
+static int jitError(Error err){
+    logAllUnhandledErrors(move(err), errs(), "hw5 --run: ");
+    return 1;
+}
+
+bool jitAvailable(){
+    return true;
+}
+
+int runJIT(const string& ir){
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+
+    auto context = make_unique<LLVMContext>();
+    SMDiagnostic diag;
+    unique_ptr<Module> module = parseIR(MemoryBufferRef(ir, "hw5"), diag, *context);
+    if(!module){
+        diag.print("hw5 --run", errs());
+        return 1;
+    }
+
+    auto jit = LLJITBuilder().create();
+    if(!jit){
+        return jitError(jit.takeError());
+    }
+
+    MangleAndInterner mangle((*jit)->getExecutionSession(), (*jit)->getDataLayout());
+    SymbolMap runtime;
+    runtime[mangle("printi0")] = JITEvaluatedSymbol::fromPointer(&hostPrinti);
+    runtime[mangle("print0")] = JITEvaluatedSymbol::fromPointer(&hostPrint);
+    runtime[mangle("divByZero")] = JITEvaluatedSymbol::fromPointer(&hostDivByZero);
+    if(Error err = (*jit)->getMainJITDylib().define(absoluteSymbols(move(runtime)))){
+        return jitError(move(err));
+    }
+
+    if(Error err = (*jit)->addIRModule(ThreadSafeModule(move(module), move(context)))){
+        return jitError(move(err));
+    }
+    auto main_sym = (*jit)->lookup("main");
+    if(!main_sym){
+        return jitError(main_sym.takeError());
+    }
+
+    auto main_func = jitTargetAddressToFunction<void (*)()>(main_sym->getAddress());
+    main_func();
+    fflush(stdout);
+    return 0;
+}
+
+#else
+
+bool jitAvailable(){
+    return false;
+}
+
+int runJIT(const string&){
+    return 1;
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HW5_JIT_H
+#define HW5_JIT_H
+
+#include <string>
+
+using namespace std;
+
+// in-process execution of the compiled program with LLVM's ORC LLJIT.
+// only available in builds made with HW5_WITH_ORC (make jit)
+
+//true if this build can run programs in-process
+bool jitAvailable();
+
+//compiles the module given as IR text and calls its main. the print0, printi0 and divByZero
+//runtime functions are bound to native functions of this process, so the module only declares them.
+//returns the process exit status
+int runJIT(const string& ir);
+
+#endif //HW5_JIT_H
@@ -0,0 +1,314 @@
+#include "Passes.hpp"
+#include "CFG.hpp"
+#include <map>
+
+/* SSA construction for the stack frame (Cytron et al.):
+ * a slot is an alloca, or a constant index into one, that is only used as
+ * the address of loads and stores. phis for a slot go on the iterated
+ * dominance frontier of the blocks storing to it, then a walk of the
+ * dominator tree replaces every load by the value reaching it. */
+
+namespace {
+
+struct SlotInfo {
+    IRType type;
+    int alloca_value;
+    vector<int> def_blocks;
+};
+
+class Mem2Reg {
+    IRFunction& func;
+    CFG cfg;
+
+    vector<Instr*> def;            // defining instruction of each value
+    vector<int> ptr_slot;          // slot addressed by a pointer value, -1 if none
+    vector<bool> alloca_escapes;   // indexed by the alloca's value
+    vector<SlotInfo> slots;
+
+    vector<vector<Instr>> new_phis; // per block
+    vector<vector<int>> new_phi_slot;
+    vector<vector<Operand>> curr_val; // per slot, stack of reaching values
+    vector<Operand> subst;
+
+    void findSlots();
+    void placePhis();
+    void rename();
+    void renameBlock(int block, vector<int>& pushed);
+    void rewrite();
+    bool isPromoted(const Instr& instr) const;
+public:
+    explicit Mem2Reg(IRFunction& func) : func(func), cfg(func) {}
+    void run();
+};
+
+void Mem2Reg::findSlots(){
+    def.assign(func.num_values, nullptr);
+    ptr_slot.assign(func.num_values, -1);
+    alloca_escapes.assign(func.num_values, false);
+
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.dst >= 0){
+                def[instr.dst] = &instr;
+            }
+        }
+    }
+
+    map<pair<int,int>,int> slot_ids;
+    auto getSlot = [&](int alloca_value, int offset, IRType type){
+        auto it = slot_ids.find({alloca_value, offset});
+        if(it != slot_ids.end()){
+            return it->second;
+        }
+        SlotInfo slot;
+        slot.type = type;
+        slot.alloca_value = alloca_value;
+        slots.push_back(slot);
+        slot_ids[{alloca_value, offset}] = int(slots.size()) - 1;
+        return int(slots.size()) - 1;
+    };
+    auto isAlloca = [&](const Operand& opnd){
+        return opnd.kind == OPND_VALUE && def[opnd.id] && def[opnd.id]->op == OP_ALLOCA;
+    };
+
+    // pointers to slots: constant geps off an alloca, or a single element alloca itself
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.op == OP_GEP && isAlloca(instr.ops[0]) && instr.ops[1].kind == OPND_CONST){
+                ptr_slot[instr.dst] = getSlot(instr.ops[0].id, instr.ops[1].id, instr.type);
+            } else if(instr.op == OP_ALLOCA && instr.ops[0].kind == OPND_CONST && instr.ops[0].id == 1){
+                ptr_slot[instr.dst] = getSlot(instr.dst, 0, instr.type);
+            }
+        }
+    }
+
+    // any other use of a slot pointer or of an alloca makes the whole alloca unpromotable
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            forEachUse(func, instr, [&](Operand& opnd){
+                if(opnd.kind != OPND_VALUE){
+                    return;
+                }
+                bool is_address = (instr.op == OP_LOAD && &opnd == &instr.ops[0])
+                               || (instr.op == OP_STORE && &opnd == &instr.ops[1]);
+                bool is_slot_gep = instr.op == OP_GEP && &opnd == &instr.ops[0] && ptr_slot[instr.dst] >= 0;
+
+                if(ptr_slot[opnd.id] >= 0 && is_address){
+                    return;
+                }
+                if(isAlloca(opnd) && is_slot_gep){
+                    return;
+                }
+                if(ptr_slot[opnd.id] >= 0){
+                    alloca_escapes[slots[ptr_slot[opnd.id]].alloca_value] = true;
+                } else if(isAlloca(opnd)){
+                    alloca_escapes[opnd.id] = true;
+                }
+            });
+        }
+    }
+
+    for(int block: cfg.rpo){
+        for(auto& instr: func.blocks[block].instrs){
+            if(instr.op == OP_STORE && isPromoted(instr)){
+                vector<int>& def_blocks = slots[ptr_slot[instr.ops[1].id]].def_blocks;
+                if(def_blocks.empty() || def_blocks.back() != block){
+                    def_blocks.push_back(block);
+                }
+            }
+        }
+    }
+}
+
+bool Mem2Reg::isPromoted(const Instr& instr) const {
+    const Operand* ptr = nullptr;
+    if(instr.op == OP_LOAD || instr.op == OP_GEP){
+        ptr = &instr.ops[0];
+    } else if(instr.op == OP_STORE){
+        ptr = &instr.ops[1];
+    }
+
+    if(instr.op == OP_ALLOCA){
+        return !alloca_escapes[instr.dst];
+    }
+    if(instr.op == OP_GEP){
+        return ptr_slot[instr.dst] >= 0 && !alloca_escapes[slots[ptr_slot[instr.dst]].alloca_value];
+    }
+    if(!ptr || ptr->kind != OPND_VALUE || ptr_slot[ptr->id] < 0){
+        return false;
+    }
+    return !alloca_escapes[slots[ptr_slot[ptr->id]].alloca_value];
+}
+
+void Mem2Reg::placePhis(){
+    int num_blocks = int(func.blocks.size());
+    new_phis.assign(num_blocks, vector<Instr>());
+    new_phi_slot.assign(num_blocks, vector<int>());
+    vector<vector<int>> df = cfg.frontiers();
+
+    vector<int> has_phi(num_blocks, -1);
+    vector<int> in_worklist(num_blocks, -1);
+    for(int slot = 0; slot < int(slots.size()); slot++){
+        if(alloca_escapes[slots[slot].alloca_value]){
+            continue;
+        }
+
+        vector<int> worklist = slots[slot].def_blocks;
+        for(int block: worklist){
+            in_worklist[block] = slot;
+        }
+        while(!worklist.empty()){
+            int block = worklist.back();
+            worklist.pop_back();
+            for(int frontier: df[block]){
+                if(has_phi[frontier] == slot){
+                    continue;
+                }
+                has_phi[frontier] = slot;
+
+                Instr phi(OP_PHI, slots[slot].type, func.num_values++);
+                phi.extra_begin = int(func.extra.size());
+                phi.extra_count = int(cfg.preds[frontier].size()) * 2;
+                for(int pred: cfg.preds[frontier]){
+                    func.extra.push_back(Operand());
+                    func.extra.push_back(Operand::label(pred));
+                }
+                new_phis[frontier].push_back(phi);
+                new_phi_slot[frontier].push_back(slot);
+
+                if(in_worklist[frontier] != slot){
+                    in_worklist[frontier] = slot;
+                    worklist.push_back(frontier);
+                }
+            }
+        }
+    }
+}
+
+void Mem2Reg::renameBlock(int block, vector<int>& pushed){
+    for(size_t i = 0; i < new_phis[block].size(); i++){
+        int slot = new_phi_slot[block][i];
+        curr_val[slot].push_back(Operand::value(new_phis[block][i].dst, slots[slot].type));
+        pushed.push_back(slot);
+    }
+
+    for(auto& instr: func.blocks[block].instrs){
+        if(instr.op != OP_PHI){
+            forEachUse(func, instr, [&](Operand& opnd){
+                while(opnd.kind == OPND_VALUE && subst[opnd.id].kind != OPND_NONE){
+                    opnd = subst[opnd.id];
+                }
+            });
+        }
+        if(!isPromoted(instr)){
+            continue;
+        }
+        if(instr.op == OP_LOAD){
+            subst[instr.dst] = curr_val[ptr_slot[instr.ops[0].id]].back();
+        } else if(instr.op == OP_STORE){
+            int slot = ptr_slot[instr.ops[1].id];
+            curr_val[slot].push_back(instr.ops[0]);
+            pushed.push_back(slot);
+        }
+    }
+
+    for(int succ: cfg.succs[block]){
+        for(int pred = 0; pred < int(cfg.preds[succ].size()); pred++){
+            if(cfg.preds[succ][pred] != block){
+                continue;
+            }
+            for(size_t i = 0; i < new_phis[succ].size(); i++){
+                phiValue(func, new_phis[succ][i], pred) = curr_val[new_phi_slot[succ][i]].back();
+            }
+        }
+    }
+}
+
+void Mem2Reg::rename(){
+    curr_val.assign(slots.size(), vector<Operand>());
+    for(int slot = 0; slot < int(slots.size()); slot++){
+        // reading a slot before any store is undefined, any value will do
+        curr_val[slot].push_back(Operand::constant(0, slots[slot].type));
+    }
+    subst.assign(func.num_values, Operand());
+
+    // iterative walk of the dominator tree, popping a block's values once its subtree is done
+    vector<vector<int>> children = cfg.domTree();
+    vector<pair<int,size_t>> stack;
+    vector<vector<int>> pushed(func.blocks.size());
+    renameBlock(0, pushed[0]);
+    stack.push_back({0, 0});
+    while(!stack.empty()){
+        int block = stack.back().first;
+        size_t& next = stack.back().second;
+        if(next < children[block].size()){
+            int child = children[block][next++];
+            renameBlock(child, pushed[child]);
+            stack.push_back({child, 0});
+        } else {
+            for(int slot: pushed[block]){
+                curr_val[slot].pop_back();
+            }
+            stack.pop_back();
+        }
+    }
+}
+
+void Mem2Reg::rewrite(){
+    for(int block = 0; block < int(func.blocks.size()); block++){
+        vector<Instr> instrs = move(new_phis[block]);
+        for(auto& instr: func.blocks[block].instrs){
+            if(!isPromoted(instr)){
+                instrs.push_back(instr);
+            }
+        }
+        func.blocks[block].instrs.swap(instrs);
+    }
+
+    // a value truncated right after being widened for the slot is the original value
+    subst.resize(func.num_values, Operand());
+    def.assign(func.num_values, nullptr);
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.dst >= 0){
+                def[instr.dst] = &instr;
+            }
+        }
+    }
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            forEachUse(func, instr, [&](Operand& opnd){
+                while(opnd.kind == OPND_VALUE && subst[opnd.id].kind != OPND_NONE){
+                    opnd = subst[opnd.id];
+                }
+            });
+            if(instr.op == OP_TRUNC && instr.ops[0].kind == OPND_VALUE){
+                Instr* widened = def[instr.ops[0].id];
+                if(widened && widened->op == OP_ZEXT && widened->ops[0].type == instr.type){
+                    subst[instr.dst] = widened->ops[0];
+                }
+            } else if((instr.op == OP_TRUNC || instr.op == OP_ZEXT) && instr.ops[0].kind == OPND_CONST){
+                // a constant passing through the slot is cast at compile time
+                IRType narrow = instr.op == OP_TRUNC ? instr.type : instr.ops[0].type;
+                int mask = narrow == IR_I1 ? 1 : narrow == IR_I8 ? 0xff : -1;
+                subst[instr.dst] = Operand::constant(instr.ops[0].id & mask, instr.type);
+            }
+        }
+    }
+    substituteValues(func, subst);
+    removeDeadValues(func);
+}
+
+void Mem2Reg::run(){
+    findSlots();
+    placePhis();
+    rename();
+    rewrite();
+}
+
+}
+
+void promoteFrameSlots(IRFunction& func){
+    removeUnreachableBlocks(func);
+    Mem2Reg(func).run();
+}
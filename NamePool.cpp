@@ -0,0 +1,69 @@
+#include "NamePool.hpp"
+#include "Compiler.hpp"
+#include <string.h>
+
+NamePool::NamePool() : names(), hashes(), slots(1024, -1) {}
+
+NamePool &NamePool::instance() {
+    return Compiler::current().namePool();
+}
+
+uint32_t NamePool::hash(const char* str, size_t len) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    for(size_t i = 0; i < len; i++){
+        h ^= (unsigned char)str[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void NamePool::grow() {
+    vector<NameId> new_slots(slots.size() * 2, -1);
+    size_t mask = new_slots.size() - 1;
+    for(NameId id = 0; id < int(names.size()); id++){
+        size_t pos = hashes[id] & mask;
+        while(new_slots[pos] != -1){
+            pos = (pos + 1) & mask;
+        }
+        new_slots[pos] = id;
+    }
+    slots.swap(new_slots);
+}
+
+NameId NamePool::intern(const char* str, size_t len) {
+    uint32_t h = hash(str, len);
+    size_t mask = slots.size() - 1;
+    size_t pos = h & mask;
+
+    while(slots[pos] != -1){
+        NameId id = slots[pos];
+        if(hashes[id] == h && names[id].size() == len && memcmp(names[id].data(), str, len) == 0){
+            return id;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    NameId id = int(names.size());
+    names.push_back(string(str, len));
+    hashes.push_back(h);
+    slots[pos] = id;
+
+    // keep the load factor under 1/2
+    if(names.size() * 2 > slots.size()){
+        grow();
+    }
+    return id;
+}
+
+NameId NamePool::intern(const string& str) {
+    return intern(str.data(), str.size());
+}
+
+const string& NamePool::str(NameId id) const {
+    return names[id];
+}
+
+int NamePool::size() const {
+    return int(names.size());
+}
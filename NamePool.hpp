@@ -0,0 +1,43 @@
+#ifndef HW5_NAME_POOL_H
+#define HW5_NAME_POOL_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+// small integer handle of an interned identifier, label or string literal
+typedef int NameId;
+
+// string interner of a compilation: equal strings get equal handles, so names
+// are compared and hashed as integers after the scanner interned them once
+class NamePool{
+    friend class Compiler;
+    NamePool();
+    NamePool(NamePool const&);
+    void operator=(NamePool const&);
+
+    deque<string> names; // deque so that references to stored names stay valid
+    vector<uint32_t> hashes;
+    vector<NameId> slots; // open addressing table of handles, -1 for empty
+
+    static uint32_t hash(const char* str, size_t len);
+    void grow();
+public:
+    //the pool of the current compilation
+    static NamePool &instance();
+
+    //returns the handle of str, adding it to the pool if it is new
+    NameId intern(const char* str, size_t len);
+    NameId intern(const string& str);
+
+    //returns the string of a handle previously returned by intern
+    const string& str(NameId id) const;
+
+    //number of distinct names interned so far, handles are in [0, size())
+    int size() const;
+};
+
+#endif //HW5_NAME_POOL_H
@@ -0,0 +1,62 @@
+#include "OutWriter.hpp"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+OutWriter::OutWriter(int fd) : fd(fd), buffer(BUFFER_SIZE), bytes_written(0) {
+    setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+bool OutWriter::writeAll(const char* data, size_t len) {
+    while(len > 0){
+        ssize_t written = ::write(fd, data, len);
+        if(written < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        len -= size_t(written);
+        bytes_written += size_t(written);
+    }
+    return true;
+}
+
+bool OutWriter::flush() {
+    bool ok = writeAll(pbase(), size_t(pptr() - pbase()));
+    setp(buffer.data(), buffer.data() + buffer.size());
+    return ok;
+}
+
+OutWriter::int_type OutWriter::overflow(int_type ch) {
+    if(!flush()){
+        return traits_type::eof();
+    }
+    if(!traits_type::eq_int_type(ch, traits_type::eof())){
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+streamsize OutWriter::xsputn(const char* s, streamsize n) {
+    if(n <= epptr() - pptr()){
+        memcpy(pptr(), s, size_t(n));
+        pbump(int(n));
+        return n;
+    }
+    // too big for what is left: write out the pending data and the chunk directly
+    if(!flush() || !writeAll(s, size_t(n))){
+        return 0;
+    }
+    return n;
+}
+
+int OutWriter::sync() {
+    return flush() ? 0 : -1;
+}
+
+size_t OutWriter::bytesWritten() const {
+    return bytes_written;
+}
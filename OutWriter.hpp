@@ -0,0 +1,33 @@
+#ifndef HW5_OUT_WRITER_H
+#define HW5_OUT_WRITER_H
+
+#include <streambuf>
+#include <vector>
+
+using namespace std;
+
+// stream buffer that writes to a file descriptor in large chunks.
+// nothing reaches the fd before the buffer fills up or flush() is called,
+// and whatever is pending when the process exits is dropped
+class OutWriter : public streambuf {
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    int fd;
+    vector<char> buffer;
+    size_t bytes_written;
+
+    bool writeAll(const char* data, size_t len);
+protected:
+    int_type overflow(int_type ch) override;
+    streamsize xsputn(const char* s, streamsize n) override;
+    int sync() override;
+public:
+    explicit OutWriter(int fd);
+
+    //writes out everything pending
+    bool flush();
+    //total bytes handed to the fd so far
+    size_t bytesWritten() const;
+};
+
+#endif //HW5_OUT_WRITER_H
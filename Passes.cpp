@@ -0,0 +1,14 @@
+#include "Passes.hpp"
+#include "CFG.hpp"
+
+void optimizeFunction(IRFunction& func, const InlineCallees& callees){
+    promoteFrameSlots(func);
+    inlineCalls(func, callees);
+    simplifyCFG(func);
+    if(elideDivChecks(func)){
+        simplifyCFG(func);
+    }
+    if(eliminateTailCalls(func)){
+        simplifyCFG(func);
+    }
+}
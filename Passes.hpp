@@ -0,0 +1,36 @@
+#ifndef HW5_PASSES_H
+#define HW5_PASSES_H
+
+#include <unordered_map>
+#include "IR.hpp"
+
+// optimization passes over a complete IRFunction, run by CodeBuffer::closeFunc
+
+// optimized functions whose calls are inlined, by mangled name
+typedef unordered_map<NameId, IRFunction> InlineCallees;
+
+//promotes the alloca frame slots that are only loaded and stored into SSA values with phis
+void promoteFrameSlots(IRFunction& func);
+
+//folds constant branches, threads jumps to jumps, merges straight-line blocks and removes
+//unreachable blocks and unused values
+void simplifyCFG(IRFunction& func);
+
+//true for a function that is small enough to be inlined into its callers, and not recursive
+bool isInlineCandidate(const IRFunction& func);
+
+//replaces the calls to the callees by a copy of their code
+void inlineCalls(IRFunction& func, const InlineCallees& callees);
+
+//drops the division by zero checks of divisors that the value ranges show can't be zero.
+//returns true if it changed the control flow
+bool elideDivChecks(IRFunction& func);
+
+//turns the calls of a function to itself in tail position into a loop, and marks its other tail calls.
+//returns true if it changed the control flow
+bool eliminateTailCalls(IRFunction& func);
+
+//runs the pass pipeline on a function whose labels are all backpatched
+void optimizeFunction(IRFunction& func, const InlineCallees& callees);
+
+#endif //HW5_PASSES_H
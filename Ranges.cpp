@@ -0,0 +1,364 @@
+#include "Passes.hpp"
+#include "CFG.hpp"
+#include <algorithm>
+#include <cstdint>
+
+/* value ranges, to drop the division by zero checks of divisors that can't be zero.
+ * every value gets an interval, and whether it is known to be nonzero (which an interval containing 0
+ * can't say, for a divisor checked before). the intervals are computed over the blocks in reverse
+ * postorder until nothing changes, and a value whose interval keeps changing (a loop counter) is
+ * widened to the bounds of its type. an operand's interval is narrowed by the conditions of the
+ * branches on the way to its use: a block whose only predecessor branches on an icmp knows the
+ * outcome of the icmp, in every block it dominates. a check is the emitted `icmp eq 0, d` branching
+ * to a block calling divByZero, it is dropped if d is nonzero where it is checked.
+ * checks are only removed, never moved: hoisting a check out of a loop would report the error
+ * before the output of the iterations ahead of the division */
+
+namespace {
+
+struct Range {
+    int64_t lo;
+    int64_t hi;
+    bool nonzero;
+
+    bool excludesZero() const { return nonzero || lo > 0 || hi < 0; }
+};
+
+// changes of a value's range beyond which it is widened
+const int MAX_RANGE_CHANGES = 3;
+
+Range fullRange(IRType type){
+    if(type == IR_I1){
+        return {0, 1, false};
+    }
+    if(type == IR_I8){
+        return {0, 255, false};
+    }
+    return {INT32_MIN, INT32_MAX, false};
+}
+
+Range unite(const Range& a, const Range& b){
+    return {min(a.lo, b.lo), max(a.hi, b.hi), a.nonzero && b.nonzero};
+}
+
+//the range of an arithmetic result, the whole type if it may wrap around
+Range fitType(int64_t lo, int64_t hi, IRType type){
+    Range full = fullRange(type);
+    if(lo < full.lo || hi > full.hi){
+        return full;
+    }
+    return {lo, hi, false};
+}
+
+ICmpPred negate(ICmpPred pred){
+    static const ICmpPred negated[] = {ICMP_NE, ICMP_EQ, ICMP_SGE, ICMP_SGT, ICMP_SLE, ICMP_SLT};
+    return negated[pred];
+}
+
+ICmpPred swapSides(ICmpPred pred){
+    static const ICmpPred swapped[] = {ICMP_EQ, ICMP_NE, ICMP_SGT, ICMP_SGE, ICMP_SLT, ICMP_SLE};
+    return swapped[pred];
+}
+
+class RangeAnalysis {
+    IRFunction& func;
+    CFG cfg;
+    vector<Instr*> def;
+    vector<Range> range;
+    vector<bool> known;
+    vector<int> changes;
+    vector<const Instr*> edge_cond; // the icmp a block's only predecessor branched on, if any
+    vector<bool> edge_taken;        // the outcome of edge_cond on the way to the block
+    vector<int> cond_up;            // nearest dominator (or the block itself) with an edge_cond
+
+    void findEdgeConds();
+    Range operandRange(const Operand& opnd) const;
+    bool refers(const Operand& opnd, const Operand& var) const;
+    void narrow(Range& r, ICmpPred pred, const Range& other) const;
+    Range transfer(const Instr& instr, int block, bool& ready) const;
+public:
+    explicit RangeAnalysis(IRFunction& func);
+    void run();
+    //the range of opnd in block, narrowed by the branches dominating it
+    Range rangeAt(const Operand& opnd, int block) const;
+    bool reachable(int block) const { return cfg.reachable(block); }
+};
+
+RangeAnalysis::RangeAnalysis(IRFunction& func)
+: func(func), cfg(func), def(func.num_values, nullptr), range(func.num_values, Range()),
+  known(func.num_values, false), changes(func.num_values, 0), edge_cond(func.blocks.size(), nullptr),
+  edge_taken(func.blocks.size(), false), cond_up(func.blocks.size(), -1) {
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.dst >= 0){
+                def[instr.dst] = &instr;
+            }
+        }
+    }
+    findEdgeConds();
+}
+
+void RangeAnalysis::findEdgeConds(){
+    for(int block: cfg.rpo){
+        if(cfg.preds[block].size() == 1){
+            const Instr& term = func.blocks[cfg.preds[block][0]].instrs.back();
+            if(term.op == OP_COND_BR && term.ops[1].id != term.ops[2].id && term.ops[0].kind == OPND_VALUE){
+                const Instr* cond = def[term.ops[0].id];
+                if(cond && cond->op == OP_ICMP){
+                    edge_cond[block] = cond;
+                    edge_taken[block] = term.ops[1].id == block;
+                }
+            }
+        }
+        // dominators come first in reverse postorder
+        if(edge_cond[block]){
+            cond_up[block] = block;
+        } else if(cfg.idom[block] >= 0){
+            cond_up[block] = cond_up[cfg.idom[block]];
+        }
+    }
+}
+
+Range RangeAnalysis::operandRange(const Operand& opnd) const {
+    if(opnd.kind == OPND_CONST){
+        return {opnd.id, opnd.id, false};
+    }
+    if(opnd.kind == OPND_VALUE && known[opnd.id]){
+        return range[opnd.id];
+    }
+    return fullRange(opnd.type);
+}
+
+//true if opnd is var, or a zero extension of it (relops compare bytes extended to i32)
+bool RangeAnalysis::refers(const Operand& opnd, const Operand& var) const {
+    if(opnd == var){
+        return true;
+    }
+    if(opnd.kind != OPND_VALUE){
+        return false;
+    }
+    const Instr* widened = def[opnd.id];
+    return widened && widened->op == OP_ZEXT && widened->ops[0] == var;
+}
+
+//narrows r to the values for which `r pred other` can hold
+void RangeAnalysis::narrow(Range& r, ICmpPred pred, const Range& other) const {
+    Range narrowed = r;
+    switch(pred){
+        case ICMP_EQ:
+            narrowed.lo = max(r.lo, other.lo);
+            narrowed.hi = min(r.hi, other.hi);
+            narrowed.nonzero |= other.excludesZero();
+            break;
+        case ICMP_NE:
+            if(other.lo == other.hi){
+                narrowed.nonzero |= other.lo == 0;
+                narrowed.lo += r.lo == other.lo;
+                narrowed.hi -= r.hi == other.lo;
+            }
+            break;
+        case ICMP_SLT:
+            narrowed.hi = min(r.hi, other.hi - 1);
+            break;
+        case ICMP_SLE:
+            narrowed.hi = min(r.hi, other.hi);
+            break;
+        case ICMP_SGT:
+            narrowed.lo = max(r.lo, other.lo + 1);
+            break;
+        case ICMP_SGE:
+            narrowed.lo = max(r.lo, other.lo);
+            break;
+    }
+    // an empty range belongs to a block that can't be reached, keeping r there is good enough
+    if(narrowed.lo <= narrowed.hi){
+        r = narrowed;
+    }
+}
+
+Range RangeAnalysis::rangeAt(const Operand& opnd, int block) const {
+    Range r = operandRange(opnd);
+    if(opnd.kind != OPND_VALUE && opnd.kind != OPND_ARG){
+        return r;
+    }
+    for(int up = cond_up[block]; up >= 0; up = cfg.idom[up] >= 0 ? cond_up[cfg.idom[up]] : -1){
+        const Instr& cond = *edge_cond[up];
+        ICmpPred pred = edge_taken[up] ? cond.pred : negate(cond.pred);
+        if(cond.ops[0].type == IR_I8 && pred != ICMP_EQ && pred != ICMP_NE){
+            continue; // bytes compare as signed, and their ranges are unsigned
+        }
+        if(refers(cond.ops[0], opnd)){
+            narrow(r, pred, operandRange(cond.ops[1]));
+        } else if(refers(cond.ops[1], opnd)){
+            narrow(r, swapSides(pred), operandRange(cond.ops[0]));
+        }
+    }
+    return r;
+}
+
+//the range of the instruction's result from the ranges of its operands so far. ready is cleared
+//when an operand has no range yet
+Range RangeAnalysis::transfer(const Instr& instr, int block, bool& ready) const {
+    auto at = [&](const Operand& opnd, int in_block){
+        if(opnd.kind == OPND_VALUE && !known[opnd.id]){
+            ready = false;
+        }
+        return rangeAt(opnd, in_block);
+    };
+    ready = true;
+
+    switch(instr.op){
+        case OP_ADD: {
+            Range a = at(instr.ops[0], block), b = at(instr.ops[1], block);
+            return fitType(a.lo + b.lo, a.hi + b.hi, instr.type);
+        }
+        case OP_SUB: {
+            Range a = at(instr.ops[0], block), b = at(instr.ops[1], block);
+            return fitType(a.lo - b.hi, a.hi - b.lo, instr.type);
+        }
+        case OP_MUL: {
+            Range a = at(instr.ops[0], block), b = at(instr.ops[1], block);
+            int64_t corners[] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+            return fitType(*min_element(corners, corners + 4), *max_element(corners, corners + 4), instr.type);
+        }
+        case OP_SDIV: {
+            // the quotient is no further from 0 than the dividend, except for INT_MIN / -1
+            Range a = at(instr.ops[0], block);
+            at(instr.ops[1], block);
+            if(a.lo == INT32_MIN){
+                return fullRange(instr.type);
+            }
+            int64_t bound = max(-a.lo, a.hi);
+            return {-bound, bound, false};
+        }
+        case OP_UDIV: {
+            Range a = at(instr.ops[0], block);
+            at(instr.ops[1], block);
+            return {0, a.hi, false};
+        }
+        case OP_ZEXT:
+            return at(instr.ops[0], block);
+        case OP_TRUNC: {
+            Range a = at(instr.ops[0], block);
+            Range full = fullRange(instr.type);
+            return a.lo >= full.lo && a.hi <= full.hi ? a : full;
+        }
+        case OP_PHI: {
+            Range r;
+            bool any = false;
+            for(int i = 0; i < phiCount(instr); i++){
+                Operand value = func.extra[instr.extra_begin + 2 * i];
+                int pred = func.extra[instr.extra_begin + 2 * i + 1].id;
+                if(value.kind == OPND_VALUE && !known[value.id]){
+                    continue; // not reached yet, comes around a loop
+                }
+                Range incoming = rangeAt(value, pred);
+                r = any ? unite(r, incoming) : incoming;
+                any = true;
+            }
+            ready = any;
+            return r;
+        }
+        default:
+            return fullRange(instr.type);
+    }
+}
+
+void RangeAnalysis::run(){
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(int block: cfg.rpo){
+            for(auto& instr: func.blocks[block].instrs){
+                if(instr.dst < 0){
+                    continue;
+                }
+                bool ready;
+                Range r = transfer(instr, block, ready);
+                if(!ready){
+                    continue;
+                }
+                int value = instr.dst;
+                if(known[value]){
+                    Range old = range[value];
+                    r = unite(old, r);
+                    if(r.lo == old.lo && r.hi == old.hi && r.nonzero == old.nonzero){
+                        continue;
+                    }
+                    if(++changes[value] > MAX_RANGE_CHANGES){
+                        Range full = fullRange(instr.type);
+                        r.lo = r.lo < old.lo ? full.lo : r.lo;
+                        r.hi = r.hi > old.hi ? full.hi : r.hi;
+                    }
+                }
+                range[value] = r;
+                known[value] = true;
+                changed = true;
+            }
+        }
+    }
+}
+
+//the divisor checked by the block's terminator, if it is a division by zero check
+bool divisorChecked(IRFunction& func, const BasicBlock& block, Operand& divisor, vector<Instr*>& def){
+    const Instr& term = block.instrs.back();
+    if(term.op != OP_COND_BR || term.ops[0].kind != OPND_VALUE){
+        return false;
+    }
+    const Instr* cond = def[term.ops[0].id];
+    if(!cond || cond->op != OP_ICMP || cond->pred != ICMP_EQ){
+        return false;
+    }
+    const BasicBlock& error = func.blocks[term.ops[1].id];
+    const Instr& call = error.instrs.front();
+    if(call.op != OP_CALL || NamePool::instance().str(call.ops[0].id) != "divByZero"){
+        return false;
+    }
+    if(cond->ops[0] == Operand::constant(0, cond->ops[0].type)){
+        divisor = cond->ops[1];
+        return true;
+    }
+    if(cond->ops[1] == Operand::constant(0, cond->ops[1].type)){
+        divisor = cond->ops[0];
+        return true;
+    }
+    return false;
+}
+
+}
+
+bool elideDivChecks(IRFunction& func){
+    vector<Instr*> def(func.num_values, nullptr);
+    bool has_checks = false;
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.dst >= 0){
+                def[instr.dst] = &instr;
+            }
+        }
+    }
+    Operand divisor;
+    for(auto& block: func.blocks){
+        has_checks |= divisorChecked(func, block, divisor, def);
+    }
+    if(!has_checks){
+        return false;
+    }
+
+    RangeAnalysis ranges(func);
+    ranges.run();
+    bool changed = false;
+    for(int block = 0; block < int(func.blocks.size()); block++){
+        if(!ranges.reachable(block) || !divisorChecked(func, func.blocks[block], divisor, def)){
+            continue;
+        }
+        if(ranges.rangeAt(divisor, block).excludesZero()){
+            Instr& term = func.blocks[block].instrs.back();
+            Instr br(OP_BR, IR_VOID);
+            br.ops[0] = term.ops[2];
+            term = br;
+            changed = true;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,197 @@
+#include "Server.hpp"
+#include "ThreadPool.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// largest source a request may carry
+const size_t MAX_REQUEST_SIZE = size_t(1) << 30;
+
+// buffered reads and whole writes on a connected socket
+class Connection {
+    static const size_t READ_SIZE = 64 * 1024;
+
+    int fd;
+    string buffer;
+    size_t pos;
+
+    bool fill(){
+        if(pos > 0){
+            buffer.erase(0, pos);
+            pos = 0;
+        }
+        size_t old_size = buffer.size();
+        buffer.resize(old_size + READ_SIZE);
+        ssize_t received;
+        do {
+            received = recv(fd, &buffer[old_size], READ_SIZE, 0);
+        } while(received < 0 && errno == EINTR);
+        buffer.resize(old_size + (received > 0 ? size_t(received) : 0));
+        return received > 0;
+    }
+public:
+    explicit Connection(int fd) : fd(fd), buffer(), pos(0) {}
+    ~Connection(){
+        close(fd);
+    }
+
+    //reads up to the next newline, which is dropped
+    bool readLine(string& line){
+        size_t end;
+        while((end = buffer.find('\n', pos)) == string::npos){
+            if(buffer.size() - pos > 4096 || !fill()){
+                return false;
+            }
+        }
+        line = buffer.substr(pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
+
+    bool readBytes(size_t size, string& data){
+        while(buffer.size() - pos < size){
+            if(!fill()){
+                return false;
+            }
+        }
+        data = buffer.substr(pos, size);
+        pos += size;
+        return true;
+    }
+
+    bool writeAll(const string& data){
+        const char* next = data.data();
+        size_t left = data.size();
+        while(left > 0){
+            // a client that went away must not kill the server with SIGPIPE
+            ssize_t sent = send(fd, next, left, MSG_NOSIGNAL);
+            if(sent < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            next += sent;
+            left -= size_t(sent);
+        }
+        return true;
+    }
+};
+
+string response(const string& status, const string& body) {
+    return status + " " + to_string(body.size()) + "\n" + body;
+}
+
+//parses a request header, setting the size of the source and the options it asks for
+bool parseHeader(const string& header, size_t& size, CompileOptions& options) {
+    istringstream fields(header);
+    string command;
+    long long num;
+    if(!(fields >> command >> num) || command != "compile" || num < 0 || size_t(num) > MAX_REQUEST_SIZE){
+        return false;
+    }
+    size = size_t(num);
+    string flag;
+    while(fields >> flag){
+        if(flag == "-O0"){
+            options.optimize = false;
+        } else if(flag == "--asm"){
+            options.emit_asm = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+//answers the requests of a connection until the client closes it. each request is compiled on the pool,
+//so idle connections hold no compile thread
+void serve(int fd, const CompileOptions& defaults, shared_ptr<ThreadPool> pool, shared_ptr<FuncCache> cache) {
+    Connection conn(fd);
+    string header;
+    while(conn.readLine(header)){
+        size_t size;
+        CompileOptions options = defaults;
+        if(!parseHeader(header, size, options)){
+            conn.writeAll(response("error", "bad request: " + header + "\n"));
+            return;
+        }
+        string source;
+        if(!conn.readBytes(size, source)){
+            return;
+        }
+
+        FILE* in = fmemopen(&source[0], source.size(), "r");
+        if(!in){
+            conn.writeAll(response("error", string("cannot read the source: ") + strerror(errno) + "\n"));
+            return;
+        }
+        ostringstream out;
+        // the task owns the promise, which must outlive set_value after the result wakes this thread
+        shared_ptr<promise<bool>> compiled = make_shared<promise<bool>>();
+        future<bool> result = compiled->get_future();
+        pool->submit([compiled, in, &out, &options, &cache]{
+            compiled->set_value(compileProgram(in, out, options, cache.get()));
+        });
+        bool ok = result.get();
+        fclose(in);
+        if(!conn.writeAll(response(ok ? "ok" : "error", out.str()))){
+            return;
+        }
+    }
+}
+
+}
+
+int runServer(const string& socket_path, int num_threads, const CompileOptions& options) {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(socket_path.size() >= sizeof(addr.sun_path)){
+        cerr << socket_path << ": socket path too long" << endl;
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path.c_str());
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd < 0){
+        perror("socket");
+        return 1;
+    }
+    unlink(socket_path.c_str());
+    if(bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 128) < 0){
+        perror(socket_path.c_str());
+        close(listen_fd);
+        return 1;
+    }
+
+    // shared with the connection threads, which may outlive this function
+    shared_ptr<FuncCache> cache(options.cache_dir.empty() ? nullptr : new FuncCache(options.cache_dir));
+    shared_ptr<ThreadPool> pool = make_shared<ThreadPool>(num_threads);
+    while(true){
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if(fd < 0){
+            if(errno == EINTR || errno == ECONNABORTED){
+                continue;
+            }
+            perror("accept");
+            break;
+        }
+        // a connection waits on its client most of the time, it gets a thread of its own
+        thread([fd, options, pool, cache]{
+            serve(fd, options, pool, cache);
+        }).detach();
+    }
+    close(listen_fd);
+    return 1;
+}
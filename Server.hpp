@@ -0,0 +1,23 @@
+#ifndef HW5_SERVER_H
+#define HW5_SERVER_H
+
+#include <string>
+#include "Compiler.hpp"
+
+using namespace std;
+
+/* compile server on a unix domain socket, so that many small compiles don't each pay for starting the
+ * process. a connection carries any number of requests, each answered in order:
+ *
+ *   request:  "compile <size>[ -O0][ --asm]\n" followed by size bytes of source
+ *   response: "ok <size>\n" followed by size bytes of code, or
+ *             "error <size>\n" followed by size bytes of diagnostic
+ *
+ * every request is compiled in a fresh compiler context (symbol table, code buffer, name pool and arena),
+ * so nothing carries over between requests. connections are served by a pool of num_threads threads */
+
+//listens on socket_path (replacing a stale socket file) until the process is killed.
+//returns nonzero if the socket couldn't be set up
+int runServer(const string& socket_path, int num_threads, const CompileOptions& options);
+
+#endif //HW5_SERVER_H
@@ -0,0 +1,360 @@
+#include "Passes.hpp"
+#include "CFG.hpp"
+#include <algorithm>
+
+/* the emitter leaves many blocks holding a single br (copyLabelStr, the end block of closeFunc,
+ * the true/false arms of evalBoolExp), and code following a terminator in blocks of its own.
+ * this pass folds branches with a known outcome, threads jumps to jumps, merges straight-line
+ * blocks and drops whatever became unreachable or unused, until nothing changes */
+
+namespace {
+
+//points the terminator's edges to block `from` at block `to`
+void retarget(Instr& term, int from, int to){
+    if(term.op == OP_BR){
+        if(term.ops[0].id == from){
+            term.ops[0].id = to;
+        }
+    } else if(term.op == OP_COND_BR){
+        for(int i = 1; i <= 2; i++){
+            if(term.ops[i].id == from){
+                term.ops[i].id = to;
+            }
+        }
+    }
+}
+
+//removes the incoming edge from pred of the phis at the start of block
+void removePhiEdge(IRFunction& func, int block, int pred){
+    for(auto& instr: func.blocks[block].instrs){
+        if(instr.op != OP_PHI){
+            break;
+        }
+        int kept_edges = 0;
+        for(int i = 0; i < phiCount(instr); i++){
+            if(phiLabel(func, instr, i).id == pred){
+                continue;
+            }
+            phiValue(func, instr, kept_edges) = phiValue(func, instr, i);
+            phiLabel(func, instr, kept_edges) = phiLabel(func, instr, i);
+            kept_edges++;
+        }
+        instr.extra_count = kept_edges * 2;
+    }
+}
+
+bool hasPhis(const BasicBlock& block){
+    return !block.instrs.empty() && block.instrs.front().op == OP_PHI;
+}
+
+bool foldICmp(ICmpPred pred, int lhs, int rhs){
+    switch(pred){
+        case ICMP_EQ: return lhs == rhs;
+        case ICMP_NE: return lhs != rhs;
+        case ICMP_SLT: return lhs < rhs;
+        case ICMP_SLE: return lhs <= rhs;
+        case ICMP_SGT: return lhs > rhs;
+        default: return lhs >= rhs; // ICMP_SGE
+    }
+}
+
+//the result of an i1 and/or/xor with a constant operand, when it's known without the other operand
+bool foldLogic(const Instr& instr, Operand& result){
+    const Operand& lhs = instr.ops[0];
+    const Operand& rhs = instr.ops[1];
+    if(lhs.kind == OPND_CONST && rhs.kind == OPND_CONST){
+        int val = instr.op == OP_AND ? lhs.id & rhs.id : instr.op == OP_OR ? lhs.id | rhs.id : lhs.id ^ rhs.id;
+        result = Operand::constant(val, IR_I1);
+        return true;
+    }
+    if(lhs.kind != OPND_CONST && rhs.kind != OPND_CONST){
+        return false;
+    }
+    const Operand& known = lhs.kind == OPND_CONST ? lhs : rhs;
+    const Operand& other = lhs.kind == OPND_CONST ? rhs : lhs;
+    if(instr.op == OP_XOR){
+        if(known.id){
+            return false;
+        }
+        result = other;
+        return true;
+    }
+    // false decides an and, true decides an or. the other constant leaves the other operand
+    bool decides = instr.op == OP_AND ? !known.id : known.id;
+    result = decides ? known : other;
+    return true;
+}
+
+//turns conditional branches with a constant condition or a single target into br
+bool foldBranches(IRFunction& func){
+    vector<Operand> subst(func.num_values, Operand());
+    bool changed = false;
+
+    for(int block = 0; block < int(func.blocks.size()); block++){
+        for(auto& instr: func.blocks[block].instrs){
+            forEachUse(func, instr, [&](Operand& opnd){
+                if(opnd.kind == OPND_VALUE && subst[opnd.id].kind != OPND_NONE){
+                    opnd = subst[opnd.id];
+                }
+            });
+            if(instr.op == OP_ICMP && instr.ops[0].kind == OPND_CONST && instr.ops[1].kind == OPND_CONST){
+                // operands of the same width, i8 constants compare as signed like the predicate does
+                int lhs = instr.ops[0].id, rhs = instr.ops[1].id;
+                if(instr.ops[0].type == IR_I8){
+                    lhs = int8_t(lhs);
+                    rhs = int8_t(rhs);
+                }
+                subst[instr.dst] = Operand::constant(foldICmp(instr.pred, lhs, rhs), IR_I1);
+            } else if(instr.op == OP_AND || instr.op == OP_OR || instr.op == OP_XOR){
+                Operand folded;
+                if(foldLogic(instr, folded)){
+                    subst[instr.dst] = folded;
+                }
+            }
+        }
+
+        Instr& term = func.blocks[block].instrs.back();
+        if(term.op != OP_COND_BR){
+            continue;
+        }
+        int target;
+        if(term.ops[1].id == term.ops[2].id){
+            target = term.ops[1].id;
+        } else if(term.ops[0].kind == OPND_CONST){
+            target = term.ops[0].id ? term.ops[1].id : term.ops[2].id;
+            removePhiEdge(func, term.ops[0].id ? term.ops[2].id : term.ops[1].id, block);
+        } else {
+            continue;
+        }
+        term = Instr(OP_BR, IR_VOID);
+        term.ops[0] = Operand::label(target);
+        changed = true;
+    }
+    return changed;
+}
+
+//sends branches to a block holding nothing but a br straight to its destination.
+//a destination with phis keeps its incoming edges as they are
+bool threadJumps(IRFunction& func){
+    int num_blocks = int(func.blocks.size());
+    vector<int> forward(num_blocks, -1);
+    for(int block = 1; block < num_blocks; block++){
+        const vector<Instr>& instrs = func.blocks[block].instrs;
+        if(instrs.size() == 1 && instrs[0].op == OP_BR && instrs[0].ops[0].id != block){
+            forward[block] = instrs[0].ops[0].id;
+        }
+    }
+
+    // final destination of each jump chain, stopping ahead of blocks with phis.
+    // a cycle of empty blocks ends at the block where it was entered
+    enum {UNVISITED, ON_PATH, DONE};
+    vector<int> dest(num_blocks, -1);
+    vector<int> state(num_blocks, UNVISITED);
+    for(int block = 0; block < num_blocks; block++){
+        vector<int> path;
+        int curr = block;
+        while(state[curr] == UNVISITED && forward[curr] >= 0 && !hasPhis(func.blocks[forward[curr]])){
+            state[curr] = ON_PATH;
+            path.push_back(curr);
+            curr = forward[curr];
+        }
+        int end = state[curr] == DONE ? dest[curr] : curr;
+        if(state[curr] == UNVISITED){
+            dest[curr] = curr;
+            state[curr] = DONE;
+        }
+        for(int i: path){
+            dest[i] = end;
+            state[i] = DONE;
+        }
+    }
+
+    bool changed = false;
+    for(auto& bb: func.blocks){
+        Instr& term = bb.instrs.back();
+        for(int succ: successors(bb)){
+            if(dest[succ] != succ){
+                retarget(term, succ, dest[succ]);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+//threads an empty block into a successor with phis when none of its predecessors reaches
+//that successor already. the phis' incoming value from the block is taken over by each predecessor
+bool threadIntoPhis(IRFunction& func){
+    CFG cfg(func);
+    bool changed = false;
+
+    for(int block: cfg.rpo){
+        const vector<Instr>& instrs = func.blocks[block].instrs;
+        if(block == 0 || instrs.size() != 1 || instrs[0].op != OP_BR){
+            continue;
+        }
+        int dest = instrs[0].ops[0].id;
+        if(dest == block || !hasPhis(func.blocks[dest])){
+            continue;
+        }
+        vector<int>& preds = cfg.preds[block];
+        vector<int>& dest_preds = cfg.preds[dest];
+        bool threadable = true;
+        for(int pred: preds){
+            if(pred == block || find(dest_preds.begin(), dest_preds.end(), pred) != dest_preds.end()){
+                threadable = false;
+            }
+        }
+        if(!threadable){
+            continue;
+        }
+
+        for(auto& phi: func.blocks[dest].instrs){
+            if(phi.op != OP_PHI){
+                break;
+            }
+            // the incoming list grows, so it moves to the end of extra
+            vector<Operand> incoming;
+            Operand val;
+            for(int i = 0; i < phiCount(phi); i++){
+                if(phiLabel(func, phi, i).id == block){
+                    val = phiValue(func, phi, i);
+                } else {
+                    incoming.push_back(phiValue(func, phi, i));
+                    incoming.push_back(phiLabel(func, phi, i));
+                }
+            }
+            for(int pred: preds){
+                incoming.push_back(val);
+                incoming.push_back(Operand::label(pred));
+            }
+            phi.extra_begin = int(func.extra.size());
+            phi.extra_count = int(incoming.size());
+            func.extra.insert(func.extra.end(), incoming.begin(), incoming.end());
+        }
+
+        for(int pred: preds){
+            retarget(func.blocks[pred].instrs.back(), block, dest);
+        }
+        dest_preds.erase(find(dest_preds.begin(), dest_preds.end(), block));
+        dest_preds.insert(dest_preds.end(), preds.begin(), preds.end());
+        preds.clear();
+        changed = true;
+    }
+    return changed;
+}
+
+//appends a block's single successor to it when the block is that successor's single predecessor
+bool mergeBlocks(IRFunction& func, vector<Operand>& subst){
+    CFG cfg(func);
+    bool changed = false;
+
+    for(int block: cfg.rpo){
+        if(func.blocks[block].instrs.empty()){
+            continue; // merged into its predecessor
+        }
+        while(true){
+            vector<Instr>& instrs = func.blocks[block].instrs;
+            if(instrs.back().op != OP_BR){
+                break;
+            }
+            int succ = instrs.back().ops[0].id;
+            if(succ == block || succ == 0 || cfg.preds[succ].size() != 1){
+                break;
+            }
+
+            instrs.pop_back();
+            for(auto& instr: func.blocks[succ].instrs){
+                if(instr.op == OP_PHI){
+                    subst[instr.dst] = phiValue(func, instr, 0);
+                } else {
+                    instrs.push_back(instr);
+                }
+            }
+            func.blocks[succ].instrs.clear();
+
+            // the successors of succ are now reached from block
+            for(int next: cfg.succs[succ]){
+                for(auto& instr: func.blocks[next].instrs){
+                    if(instr.op != OP_PHI){
+                        break;
+                    }
+                    for(int i = 0; i < phiCount(instr); i++){
+                        if(phiLabel(func, instr, i).id == succ){
+                            phiLabel(func, instr, i).id = block;
+                        }
+                    }
+                }
+                for(int& pred: cfg.preds[next]){
+                    if(pred == succ){
+                        pred = block;
+                    }
+                }
+            }
+            cfg.succs[block] = cfg.succs[succ];
+            changed = true;
+        }
+    }
+
+    if(changed){
+        // merged blocks are left empty, give them a terminator until they are removed as unreachable
+        for(auto& bb: func.blocks){
+            if(bb.instrs.empty()){
+                bb.instrs.push_back(Instr(OP_UNREACHABLE, IR_VOID));
+            }
+        }
+    }
+    return changed;
+}
+
+//replaces phis whose incoming values are all the same value
+bool removeTrivialPhis(IRFunction& func, vector<Operand>& subst){
+    bool changed = false;
+    for(auto& bb: func.blocks){
+        for(auto& instr: bb.instrs){
+            if(instr.op != OP_PHI){
+                break;
+            }
+            Operand same;
+            bool trivial = true;
+            for(int i = 0; i < phiCount(instr) && trivial; i++){
+                Operand val = phiValue(func, instr, i);
+                while(val.kind == OPND_VALUE && subst[val.id].kind != OPND_NONE){
+                    val = subst[val.id];
+                }
+                if(val.kind == OPND_VALUE && val.id == instr.dst){
+                    continue;
+                }
+                if(same.kind == OPND_NONE){
+                    same = val;
+                } else if(!(same == val)){
+                    trivial = false;
+                }
+            }
+            if(trivial && same.kind != OPND_NONE && subst[instr.dst].kind == OPND_NONE){
+                subst[instr.dst] = same;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+}
+
+void simplifyCFG(IRFunction& func){
+    bool changed = true;
+    while(changed){
+        changed = foldBranches(func);
+        changed |= threadJumps(func);
+        changed |= threadIntoPhis(func);
+        removeUnreachableBlocks(func);
+
+        vector<Operand> subst(func.num_values, Operand());
+        changed |= mergeBlocks(func, subst);
+        removeUnreachableBlocks(func);
+        changed |= removeTrivialPhis(func, subst);
+        substituteValues(func, subst);
+        removeDeadValues(func);
+    }
+}
@@ -6,7 +6,7 @@ void printSymbol(SymTableEntry* sym);
 
 SymTableEntry::SymTableEntry(
         int scope,
-        const char* name,
+        NameId name,
         int offset,
         Type type,
         vector<Type> arg_types = {},
@@ -15,13 +15,15 @@ SymTableEntry::SymTableEntry(
         int func_idx = 0,
         SymTableEntry* next = nullptr
         )
-: scope(scope), name(string(name)), offset(offset),
+: scope(scope), name(name), offset(offset),
   type(type), arg_types(move(arg_types)), is_func(is_func),
-  is_override(is_override), func_idx(func_idx), next(next)
+  is_override(is_override), func_idx(func_idx), next(next),
+  shadowed(nullptr)
 {}
 
-SymTable::SymTable() {
+SymTable::SymTable(CompileStats& stats) : stats(stats) {
     head = nullptr;
+    outer = nullptr;
     curr_scope = 0;
     offset_stack.push_back(0);
 }
@@ -32,40 +34,89 @@ SymTable::~SymTable() {
         head = head->next;
         delete temp;
     }
+    for(auto entry: outer_entries){
+        delete entry;
+    }
 }
 
-void SymTable::addVarSymbol(const char* name, Type type) {
-    // assuming the caller checked before that var doesn't exists already
-    SymTableEntry* new_sym = new SymTableEntry(curr_scope, name, offset_stack.back(), type);
+void SymTable::setOuterFuncs(OuterFuncs* outer_funcs) {
+    outer = outer_funcs;
+}
+
+void SymTable::reserveName(NameId name) {
+    if(name >= int(var_index.size())) {
+        var_index.resize(NamePool::instance().size(), nullptr);
+        func_index.resize(NamePool::instance().size());
+        outer_found.resize(NamePool::instance().size(), false);
+    }
+}
+
+void SymTable::findOuterFuncs(NameId name) {
+    reserveName(name);
+    if(outer_found[name]) {
+        return;
+    }
+    outer_found[name] = true;
+
+    vector<SymTableEntry*> found = outer->find(name);
+    vector<SymTableEntry*>& funcs = func_index[name];
+    funcs.insert(funcs.begin(), found.begin(), found.end());
+    outer_entries.insert(outer_entries.end(), found.begin(), found.end());
+}
+
+void SymTable::pushEntry(SymTableEntry* new_sym) {
     new_sym->next = head;
     head = new_sym;
+
+    reserveName(new_sym->name);
+
+    if(new_sym->is_func) {
+        func_index[new_sym->name].push_back(new_sym);
+    } else {
+        SymTableEntry*& innermost = var_index[new_sym->name];
+        new_sym->shadowed = innermost;
+        innermost = new_sym;
+    }
+}
+
+void SymTable::popEntry() {
+    stats.entries_walked++;
+    SymTableEntry* temp = head;
+    head = head->next;
+
+    if(temp->is_func) {
+        func_index[temp->name].pop_back();
+    } else {
+        var_index[temp->name] = temp->shadowed;
+    }
+
+    delete temp;
+}
+
+void SymTable::addVarSymbol(NameId name, Type type) {
+    // assuming the caller checked before that var doesn't exists already
+    pushEntry(new SymTableEntry(curr_scope, name, offset_stack.back(), type));
     offset_stack.back()++;
 }
 
-void SymTable::addArgSymbol(const char* name, Type type, int offset) {
-    SymTableEntry* new_sym = new SymTableEntry(curr_scope, name, offset, type);
-    new_sym->next = head;
-    head = new_sym;
+void SymTable::addArgSymbol(NameId name, Type type, int offset) {
+    pushEntry(new SymTableEntry(curr_scope, name, offset, type));
 }
 
-void SymTable::addFuncSymbol(const char* name, Type ret_type, vector<Type> arg_types, bool is_override, int func_idx) {
+void SymTable::addFuncSymbol(NameId name, Type ret_type, vector<Type> arg_types, bool is_override, int func_idx) {
     // assuming the caller checked before that same func doesn't exit already
     // scope and offset should be 0
-    head = new SymTableEntry(curr_scope, name, offset_stack.back(), ret_type,
-                             move(arg_types), true, is_override, func_idx, head);
+    pushEntry(new SymTableEntry(curr_scope, name, offset_stack.back(), ret_type,
+                                move(arg_types), true, is_override, func_idx));
 }
 
-SymTableEntry* SymTable::getVarSymbol(const char* name) {
-    SymTableEntry* curr = head;
-
-    while(curr) {
-        if(curr->name == name && !curr->is_func) {
-            return curr;
-        }
-        curr = curr->next;
+SymTableEntry* SymTable::getVarSymbol(NameId name) {
+    stats.symbol_lookups++;
+    if(name >= int(var_index.size())) {
+        return nullptr;
     }
 
-    return nullptr;
+    return var_index[name];
 }
 
 bool argTypesCompatible(vector<Type>& expected_types, vector<Type>& arg_types){
@@ -83,40 +134,35 @@ bool argTypesCompatible(vector<Type>& expected_types, vector<Type>& arg_types){
     return true;
 }
 
-vector<SymTableEntry*> SymTable::getFuncSymbol(const char *name, vector<Type> arg_types) {
-    SymTableEntry* curr = head;
+vector<SymTableEntry*> SymTable::getFuncSymbol(NameId name, vector<Type> arg_types) {
     vector<SymTableEntry*> candidates;
 
-    while(curr) {
-        if(curr->name == name && curr->is_func
-           && argTypesCompatible(curr->arg_types, arg_types)) {
-            candidates.push_back(curr);
+    for(auto& func: getFuncsByName(name)) {
+        stats.entries_walked++;
+        if(argTypesCompatible(func->arg_types, arg_types)) {
+            candidates.push_back(func);
         }
-        curr = curr->next;
     }
 
     return candidates;
 }
 
-vector<SymTableEntry*> SymTable::getFuncsByName(const char *func_name) {
-    SymTableEntry* curr = head;
-    vector<SymTableEntry*> matches;
-
-    while(curr) {
-        if(curr->name == func_name && curr->is_func) {
-            matches.push_back(curr);
-        }
-        curr = curr->next;
+const vector<SymTableEntry*>& SymTable::getFuncsByName(NameId func_name) {
+    static const vector<SymTableEntry*> no_funcs;
+    stats.symbol_lookups++;
+    if(outer) {
+        findOuterFuncs(func_name);
+    }
+    if(func_name >= int(func_index.size())) {
+        return no_funcs;
     }
 
-    return matches;
+    return func_index[func_name];
 }
 
 void SymTable::deleteTopScope() {
     while(head && head->scope == curr_scope){
-        SymTableEntry* temp = head;
-        head = head->next;
-        delete temp;
+        popEntry();
     }
 
     curr_scope--;
@@ -132,7 +178,7 @@ void printSymbol(SymTableEntry* sym){
     vector<string> type_to_string = {"STRING","INT","BYTE","BOOL","VOID"};
 
     if(!sym->is_func) {
-        output::printID(sym->name, sym->offset, type_to_string[sym->type]);
+        output::printID(NamePool::instance().str(sym->name), sym->offset, type_to_string[sym->type]);
         return;
     }
     // symbol is a function
@@ -140,7 +186,7 @@ void printSymbol(SymTableEntry* sym){
     for(auto& type: sym->arg_types){
         str_arg_types.push_back(type_to_string[type]);
     }
-    output::printID(sym->name, sym->offset, output::makeFunctionType(type_to_string[sym->type], str_arg_types));
+    output::printID(NamePool::instance().str(sym->name), sym->offset, output::makeFunctionType(type_to_string[sym->type], str_arg_types));
 }
 
 void recPrintTopScope(SymTableEntry* curr, int scope){
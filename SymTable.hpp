@@ -3,13 +3,16 @@
 
 #include "attributes.h"
 #include "hw3_output.hpp"
+#include "CompileStats.hpp"
 
 class SymTableEntry {
 public:
     int scope;
-    string name;
+    NameId name;
     int offset;
     Type type;
+    // address of the variable's (or argument's) stack slot, set once its code is emitted
+    Operand slot;
 
     // for functions
     vector<Type> arg_types;
@@ -18,9 +21,11 @@ public:
     int func_idx;
 
     SymTableEntry* next;
+    // next outer variable with the same name (shadow chain)
+    SymTableEntry* shadowed;
 
     SymTableEntry(int scope,
-                  const char* name,
+                  NameId name,
                   int offset,
                   Type type,
                   vector<Type> arg_types,
@@ -31,23 +36,53 @@ public:
     ~SymTableEntry() = default;
 };
 
-// linked list of SymTableEntry
+// functions a table doesn't declare itself: a function compiled on its own sees the
+// functions declared ahead of it in the program through them
+class OuterFuncs {
+public:
+    virtual ~OuterFuncs() {}
+    //the outer functions called name, in declaration order. the table takes ownership of the entries
+    virtual vector<SymTableEntry*> find(NameId name) = 0;
+};
+
+// linked list of SymTableEntry, indexed by name
 class SymTable {
     SymTableEntry* head;
     int curr_scope;
     vector<int> offset_stack;
 
+    // indexed by NameId: innermost variable, older ones are reachable through shadowed
+    vector<SymTableEntry*> var_index;
+    // indexed by NameId: overload set, in declaration order
+    vector<vector<SymTableEntry*>> func_index;
+
+    OuterFuncs* outer;
+    // indexed by NameId: whether the outer functions of the name were looked up
+    vector<bool> outer_found;
+    vector<SymTableEntry*> outer_entries;
+
+    CompileStats& stats;
+
+    void reserveName(NameId name);
+    void findOuterFuncs(NameId name);
+    void pushEntry(SymTableEntry* new_sym);
+    void popEntry();
+
 public:
-    SymTable();
+    //lookups and walked entries are counted in stats
+    explicit SymTable(CompileStats& stats);
     ~SymTable();
 
-    void addVarSymbol(const char* name, Type type);
-    void addArgSymbol(const char* name, Type type, int offset);
-    void addFuncSymbol(const char* name, Type ret_type, vector<Type> arg_types, bool is_override, int func_idx);
+    //functions not found in the table are looked up in outer, ahead of the ones declared here
+    void setOuterFuncs(OuterFuncs* outer_funcs);
+
+    void addVarSymbol(NameId name, Type type);
+    void addArgSymbol(NameId name, Type type, int offset);
+    void addFuncSymbol(NameId name, Type ret_type, vector<Type> arg_types, bool is_override, int func_idx);
 
-    SymTableEntry* getVarSymbol(const char* name);
-    vector<SymTableEntry*> getFuncSymbol(const char* name, vector<Type> arg_types);
-    vector<SymTableEntry*> getFuncsByName(const char* func_name);
+    SymTableEntry* getVarSymbol(NameId name);
+    vector<SymTableEntry*> getFuncSymbol(NameId name, vector<Type> arg_types);
+    const vector<SymTableEntry*>& getFuncsByName(NameId func_name);
 
     void deleteTopScope();
     void addNewScope();
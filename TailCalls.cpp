@@ -0,0 +1,127 @@
+#include "Passes.hpp"
+#include "CFG.hpp"
+
+/* tail calls: calls whose result the function returns right away (return f(...), or a void call
+ * ending the function). a tail call of the function itself becomes a branch back to its start, with
+ * phis at the start passing the arguments of the call, so self recursion runs as a loop in a constant
+ * amount of stack. the other tail calls are marked tail, for LLVM and for the --asm backend, which
+ * jumps to the callee instead of calling it.
+ * the frame slots must be promoted first: a callee could otherwise see a slot of the caller's frame
+ * that a tail call has already released */
+
+namespace {
+
+//true when the block ends with a call and a ret of its result, or with a void call and a branch to a
+//block holding only a ret void
+bool endsWithTailCall(const IRFunction& func, const BasicBlock& block){
+    size_t size = block.instrs.size();
+    if(size < 2 || block.instrs[size - 2].op != OP_CALL){
+        return false;
+    }
+    const Instr& call = block.instrs[size - 2];
+    const Instr* ret = &block.instrs[size - 1];
+    if(ret->op == OP_BR && call.type == IR_VOID){
+        const BasicBlock& succ = func.blocks[ret->ops[0].id];
+        if(succ.instrs.empty()){
+            return false;
+        }
+        ret = &succ.instrs[0];
+    }
+    if(ret->op != OP_RET){
+        return false;
+    }
+    if(call.type == IR_VOID){
+        return ret->ops[0].kind == OPND_NONE;
+    }
+    return ret->ops[0] == Operand::value(call.dst, call.type);
+}
+
+//turns the calls of func to itself ending tail_blocks into branches to a loop around its code
+void loopSelfCalls(IRFunction& func, vector<int>& tail_blocks){
+    // the entry's code moves to a new block, the loop header, and the entry branches to it
+    int header = int(func.blocks.size());
+    func.blocks.push_back(BasicBlock());
+    func.blocks[header].instrs.swap(func.blocks[0].instrs);
+    Instr enter(OP_BR, IR_VOID);
+    enter.ops[0] = Operand::label(header);
+    func.blocks[0].instrs.push_back(enter);
+    for(int succ: successors(func.blocks[header])){
+        renamePhiEdges(func, succ, 0, header);
+    }
+    for(int& block: tail_blocks){
+        if(block == 0){
+            block = header;
+        }
+    }
+
+    // the arguments are read through a phi each
+    vector<Operand> params;
+    for(IRType type: func.arg_types){
+        params.push_back(Operand::value(func.num_values++, type));
+    }
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            forEachUse(func, instr, [&](Operand& opnd){
+                if(opnd.kind == OPND_ARG){
+                    opnd = params[opnd.id - 1];
+                }
+            });
+        }
+    }
+
+    vector<Instr> phis;
+    for(size_t i = 0; i < params.size(); i++){
+        Instr phi(OP_PHI, params[i].type, params[i].id);
+        phi.extra_begin = int(func.extra.size());
+        phi.extra_count = 2 * (1 + int(tail_blocks.size()));
+        func.extra.push_back(Operand::arg(int(i) + 1, params[i].type));
+        func.extra.push_back(Operand::label(0));
+        for(int block: tail_blocks){
+            const Instr& call = func.blocks[block].instrs[func.blocks[block].instrs.size() - 2];
+            Operand arg = func.extra[call.extra_begin + i];
+            func.extra.push_back(arg);
+            func.extra.push_back(Operand::label(block));
+        }
+        phis.push_back(phi);
+    }
+
+    for(int block: tail_blocks){
+        auto& instrs = func.blocks[block].instrs;
+        instrs.erase(instrs.end() - 2, instrs.end());
+        Instr loop(OP_BR, IR_VOID);
+        loop.ops[0] = Operand::label(header);
+        instrs.push_back(loop);
+    }
+    auto& header_instrs = func.blocks[header].instrs;
+    header_instrs.insert(header_instrs.begin(), phis.begin(), phis.end());
+}
+
+}
+
+bool eliminateTailCalls(IRFunction& func){
+    for(auto& block: func.blocks){
+        for(auto& instr: block.instrs){
+            if(instr.op == OP_ALLOCA){
+                return false;
+            }
+        }
+    }
+
+    vector<int> self_calls;
+    for(int block = 0; block < int(func.blocks.size()); block++){
+        if(!endsWithTailCall(func, func.blocks[block])){
+            continue;
+        }
+        Instr& call = func.blocks[block].instrs[func.blocks[block].instrs.size() - 2];
+        if(call.ops[0].id == func.name){
+            self_calls.push_back(block);
+        } else {
+            call.tail = true;
+        }
+    }
+    if(self_calls.empty()){
+        return false;
+    }
+    loopSelfCalls(func, self_calls);
+    return true;
+}
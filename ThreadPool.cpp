@@ -0,0 +1,93 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int num_threads) : workers(), threads(), queued(0), pending(0), next(0), stopping(false) {
+    if(num_threads < 1){
+        num_threads = 1;
+    }
+    for(int i = 0; i < num_threads; i++){
+        workers.emplace_back(new Worker());
+    }
+    for(int i = 0; i < num_threads; i++){
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> guard(idle_lock);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for(auto& t: threads){
+        t.join();
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    Worker& worker = *workers[next++ % workers.size()];
+    {
+        lock_guard<mutex> guard(worker.lock);
+        worker.tasks.push_back(move(task));
+    }
+    // counted under idle_lock, so a worker can't miss it between checking for work and going to sleep
+    {
+        lock_guard<mutex> guard(idle_lock);
+        queued++;
+        pending++;
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(idle_lock);
+    all_done.wait(guard, [this]{ return pending == 0; });
+}
+
+bool ThreadPool::popTask(int worker, function<void()>& task) {
+    // own tasks newest first
+    {
+        Worker& own = *workers[worker];
+        lock_guard<mutex> guard(own.lock);
+        if(!own.tasks.empty()){
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    // then steal the oldest task of the others
+    int num_workers = int(workers.size());
+    for(int i = 1; i < num_workers; i++){
+        Worker& victim = *workers[(worker + i) % num_workers];
+        lock_guard<mutex> guard(victim.lock);
+        if(!victim.tasks.empty()){
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(int worker) {
+    function<void()> task;
+    while(true){
+        if(popTask(worker, task)){
+            task();
+            task = nullptr;
+            lock_guard<mutex> guard(idle_lock);
+            if(--pending == 0){
+                all_done.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> guard(idle_lock);
+        work_available.wait(guard, [this]{ return stopping || queued > 0; });
+        if(stopping){
+            return;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef HW5_THREAD_POOL_H
+#define HW5_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// fixed set of worker threads, each with a deque of its own tasks. a worker runs its newest task
+// first, and when its deque is empty steals the oldest task of another worker, so a few long
+// compilations don't leave the other threads idle behind them
+class ThreadPool {
+    struct Worker {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    vector<thread> threads;
+    atomic<int> queued;    // tasks waiting in the deques
+    int pending;           // submitted tasks that haven't finished, guarded by idle_lock
+    atomic<unsigned> next; // worker receiving the next submitted task
+    bool stopping;
+    mutex idle_lock;
+    condition_variable work_available;
+    condition_variable all_done;
+
+    ThreadPool(ThreadPool const&);
+    void operator=(ThreadPool const&);
+
+    bool popTask(int worker, function<void()>& task);
+    void run(int worker);
+public:
+    explicit ThreadPool(int num_threads);
+    //waits for the submitted tasks and joins the threads
+    ~ThreadPool();
+
+    void submit(function<void()> task);
+
+    //blocks until every submitted task has finished
+    void wait();
+};
+
+#endif //HW5_THREAD_POOL_H
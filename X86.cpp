@@ -0,0 +1,743 @@
+#include "X86.hpp"
+#include "CFG.hpp"
+#include <algorithm>
+
+namespace {
+
+enum Reg {RAX, RBX, RCX, RDX, RSI, RDI, RBP, RSP, R8, R9, R10, R11, R12, R13, R14, R15, NO_REG = -1};
+
+const char* reg64[] = {"%rax", "%rbx", "%rcx", "%rdx", "%rsi", "%rdi", "%rbp", "%rsp",
+                       "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"};
+const char* reg32[] = {"%eax", "%ebx", "%ecx", "%edx", "%esi", "%edi", "%ebp", "%esp",
+                       "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"};
+const char* reg8[] = {"%al", "%bl", "%cl", "%dl", "%sil", "%dil", "%bpl", "%spl",
+                      "%r8b", "%r9b", "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b"};
+
+const Reg arg_regs[] = {RDI, RSI, RDX, RCX, R8, R9};
+const int NUM_ARG_REGS = 6;
+
+// rax, rcx, rdx and r11 are the scratch registers of the instruction patterns and are never allocated.
+// a value live across a call can only get a callee saved register
+const Reg caller_saved[] = {RSI, RDI, R8, R9, R10};
+const Reg callee_saved[] = {RBX, R12, R13, R14, R15};
+
+bool isPointer(IRType type){
+    return type == IR_I8_PTR || type == IR_I32_PTR || type == IR_I1_PTR;
+}
+
+const char* regName(int reg, IRType type){
+    return isPointer(type) ? reg64[reg] : reg32[reg];
+}
+
+char suffix(IRType type){
+    return isPointer(type) ? 'q' : 'l';
+}
+
+int elementSize(IRType type){
+    return type == IR_I32 ? 4 : 1;
+}
+
+const char* setcc(ICmpPred pred){
+    static const char* ops[] = {"sete", "setne", "setl", "setle", "setg", "setge"};
+    return ops[pred];
+}
+
+template<class F>
+void forEachOperand(const IRFunction& func, const Instr& instr, F f){
+    for(int i = 0; i < 3; i++){
+        f(instr.ops[i]);
+    }
+    for(int i = 0; i < instr.extra_count; i++){
+        f(func.extra[instr.extra_begin + i]);
+    }
+}
+
+struct Interval {
+    int value;
+    int start;
+    int end;
+    bool crosses_call;
+};
+
+class AsmFunction {
+    ostream& os;
+    const IRFunction& func;
+    const string& name;
+    int num_blocks;
+
+    vector<IRType> value_type;
+    vector<int> def_block;
+    vector<int> block_start;    // position of the block's phis
+    vector<int> block_end;      // position of the block's terminator
+    vector<Interval> intervals;
+
+    vector<int> reg_of;         // register of each value, NO_REG if it lives in a stack slot
+    vector<int> slot_of;        // rbp offset of each spilled value
+    vector<int> storage_of;     // rbp offset of the memory an alloca points to
+    vector<int> arg_slot;       // rbp offset each argument is copied to, by 1 based index
+    vector<int> temp_slots;     // staging area for parallel copies that overlap
+    vector<Reg> saved_regs;     // callee saved registers the function uses
+    int frame_bytes;
+
+    void computeIntervals();
+    void allocateRegisters();
+    int allocSlot(int bytes);
+    void layoutFrame();
+
+    string loc(int value) const;
+    string opnd(const Operand& o) const;
+    void loadTo(const Operand& o, int reg);
+    void storeFrom(int reg, int value);
+    string label(int block) const;
+
+    void emitEdge(int block, int succ);
+    void emitInstr(int block, const Instr& instr);
+    //restores the callee saved registers, rsp and rbp of the caller
+    void emitLeave();
+public:
+    AsmFunction(ostream& os, const IRFunction& func)
+    : os(os), func(func), name(NamePool::instance().str(func.name)), num_blocks(int(func.blocks.size())),
+      value_type(func.num_values, IR_VOID), def_block(func.num_values, -1), block_start(num_blocks),
+      block_end(num_blocks), intervals(), reg_of(func.num_values, NO_REG), slot_of(func.num_values, 0),
+      storage_of(func.num_values, 0),
+      arg_slot(func.arg_types.size() + 1, 0), temp_slots(), saved_regs(), frame_bytes(0) {}
+    void emit();
+};
+
+void AsmFunction::computeIntervals(){
+    // instructions are numbered by 2 in block order, the phis of a block share its start position
+    // and the copies feeding a successor's phis happen at the end position + 1
+    vector<int> def_pos(func.num_values, -1);
+    vector<int> call_pos;
+    int pos = 0;
+    for(int block = 0; block < num_blocks; block++){
+        block_start[block] = pos;
+        for(auto& instr: func.blocks[block].instrs){
+            if(instr.op != OP_PHI){
+                pos += 2;
+            }
+            if(instr.op == OP_CALL){
+                call_pos.push_back(pos);
+            }
+            if(instr.dst >= 0){
+                def_pos[instr.dst] = instr.op == OP_PHI ? block_start[block] : pos;
+                def_block[instr.dst] = block;
+                IRType type = instr.type;
+                if(instr.op == OP_ALLOCA || instr.op == OP_GEP){
+                    type = IR_I32_PTR;
+                } else if(instr.op == OP_STR_PTR){
+                    type = IR_I8_PTR;
+                }
+                value_type[instr.dst] = type;
+            }
+        }
+        block_end[block] = pos;
+        pos += 2;
+    }
+
+    // uses of each value by block, a phi's use is at the end of the incoming block, encoded as ~block
+    vector<vector<int>> uses(func.num_values);
+    vector<int> start(func.num_values, -1), end(func.num_values, -1);
+    auto extend = [&](int value, int p){
+        if(start[value] < 0 || p < start[value]){
+            start[value] = p;
+        }
+        end[value] = max(end[value], p);
+    };
+    pos = 0;
+    for(int block = 0; block < num_blocks; block++){
+        pos = block_start[block];
+        for(auto& instr: func.blocks[block].instrs){
+            if(instr.op == OP_PHI){
+                for(int i = 0; i < instr.extra_count; i += 2){
+                    const Operand& val = func.extra[instr.extra_begin + i];
+                    if(val.kind == OPND_VALUE){
+                        uses[val.id].push_back(~func.extra[instr.extra_begin + i + 1].id);
+                    }
+                }
+                continue;
+            }
+            pos += 2;
+            forEachOperand(func, instr, [&](const Operand& o){
+                if(o.kind == OPND_VALUE){
+                    extend(o.id, pos);
+                    uses[o.id].push_back(block);
+                }
+            });
+        }
+    }
+
+    // walk up from the uses to the definition, the value is live at every block boundary on the way
+    CFG cfg(func);
+    vector<int> visited(num_blocks, -1);
+    vector<int> live_out;
+    for(int value = 0; value < func.num_values; value++){
+        if(def_pos[value] < 0){
+            continue;
+        }
+        extend(value, def_pos[value]);
+        int def = def_block[value];
+        live_out.clear();
+        auto liveIn = [&](int block){
+            if(visited[block] == value){
+                return;
+            }
+            visited[block] = value;
+            extend(value, block_start[block]);
+            live_out.insert(live_out.end(), cfg.preds[block].begin(), cfg.preds[block].end());
+        };
+        for(int use: uses[value]){
+            if(use < 0){
+                live_out.push_back(~use);
+            } else if(use != def){
+                liveIn(use);
+            }
+        }
+        while(!live_out.empty()){
+            int block = live_out.back();
+            live_out.pop_back();
+            extend(value, block_end[block] + 1);
+            if(block != def){
+                liveIn(block);
+            }
+        }
+
+        Interval interval = {value, start[value], end[value], false};
+        auto call = upper_bound(call_pos.begin(), call_pos.end(), interval.start);
+        interval.crosses_call = call != call_pos.end() && *call < interval.end;
+        intervals.push_back(interval);
+    }
+}
+
+void AsmFunction::allocateRegisters(){
+    sort(intervals.begin(), intervals.end(), [](const Interval& a, const Interval& b){
+        return a.start < b.start || (a.start == b.start && a.value < b.value);
+    });
+
+    vector<bool> reg_free(16, false);
+    for(Reg reg: caller_saved){
+        reg_free[reg] = true;
+    }
+    for(Reg reg: callee_saved){
+        reg_free[reg] = true;
+    }
+    vector<bool> reg_used(16, false);
+
+    vector<const Interval*> active;
+    for(auto& curr: intervals){
+        // a value ending where another starts can share its register, operands are read before the result is written
+        for(size_t i = 0; i < active.size();){
+            if(active[i]->end <= curr.start){
+                reg_free[reg_of[active[i]->value]] = true;
+                active[i] = active.back();
+                active.pop_back();
+            } else {
+                i++;
+            }
+        }
+
+        auto allowed = [&](int reg){
+            return !curr.crosses_call || find(begin(callee_saved), end(callee_saved), reg) != end(callee_saved);
+        };
+        int reg = NO_REG;
+        if(!curr.crosses_call){
+            for(Reg r: caller_saved){
+                if(reg_free[r]){
+                    reg = r;
+                    break;
+                }
+            }
+        }
+        if(reg == NO_REG){
+            for(Reg r: callee_saved){
+                if(reg_free[r]){
+                    reg = r;
+                    break;
+                }
+            }
+        }
+
+        if(reg == NO_REG){
+            // spill whichever of the current and the usable active intervals ends last
+            const Interval* victim = nullptr;
+            size_t victim_idx = 0;
+            for(size_t i = 0; i < active.size(); i++){
+                if(allowed(reg_of[active[i]->value]) && (!victim || active[i]->end > victim->end)){
+                    victim = active[i];
+                    victim_idx = i;
+                }
+            }
+            if(!victim || victim->end <= curr.end){
+                continue; // curr stays in its stack slot
+            }
+            reg = reg_of[victim->value];
+            reg_of[victim->value] = NO_REG;
+            active[victim_idx] = active.back();
+            active.pop_back();
+        }
+
+        reg_free[reg] = false;
+        reg_used[reg] = true;
+        reg_of[curr.value] = reg;
+        active.push_back(&curr);
+    }
+
+    for(Reg reg: callee_saved){
+        if(reg_used[reg]){
+            saved_regs.push_back(reg);
+        }
+    }
+}
+
+int AsmFunction::allocSlot(int bytes){
+    frame_bytes += (bytes + 7) / 8 * 8;
+    return -(8 * int(saved_regs.size()) + frame_bytes);
+}
+
+void AsmFunction::layoutFrame(){
+    for(size_t arg = 1; arg < arg_slot.size(); arg++){
+        arg_slot[arg] = allocSlot(8);
+    }
+    for(auto& interval: intervals){
+        if(reg_of[interval.value] == NO_REG){
+            slot_of[interval.value] = allocSlot(8);
+        }
+    }
+
+    size_t max_phis = 0;
+    for(auto& block: func.blocks){
+        size_t phis = 0;
+        for(auto& instr: block.instrs){
+            if(instr.op == OP_ALLOCA){
+                storage_of[instr.dst] = allocSlot(elementSize(instr.type) * instr.ops[0].id);
+            }
+            phis += instr.op == OP_PHI;
+        }
+        max_phis = max(max_phis, phis);
+    }
+    for(size_t i = 0; i < max_phis; i++){
+        temp_slots.push_back(allocSlot(8));
+    }
+
+    // rsp is 16 byte aligned after pushing rbp, keep it so below the saved registers and the frame
+    if((8 * saved_regs.size() + frame_bytes) % 16){
+        frame_bytes += 8;
+    }
+}
+
+
+string AsmFunction::loc(int value) const {
+    if(reg_of[value] != NO_REG){
+        return regName(reg_of[value], value_type[value]);
+    }
+    return to_string(slot_of[value]) + "(%rbp)";
+}
+
+string AsmFunction::opnd(const Operand& o) const {
+    if(o.kind == OPND_CONST){
+        return "$" + to_string(o.id);
+    } else if(o.kind == OPND_ARG){
+        return to_string(arg_slot[o.id]) + "(%rbp)";
+    }
+    return loc(o.id);
+}
+
+void AsmFunction::loadTo(const Operand& o, int reg){
+    if(o.kind == OPND_VALUE && reg_of[o.id] == reg){
+        return;
+    }
+    os << "\tmov" << suffix(o.type) << " " << opnd(o) << ", " << regName(reg, o.type) << "\n";
+}
+
+void AsmFunction::storeFrom(int reg, int value){
+    if(reg_of[value] == reg){
+        return;
+    }
+    os << "\tmov" << suffix(value_type[value]) << " " << regName(reg, value_type[value]) << ", " << loc(value) << "\n";
+}
+
+string AsmFunction::label(int block) const {
+    return ".L" + name + "_" + to_string(block);
+}
+
+void AsmFunction::emitEdge(int block, int succ){
+    // the phis of succ read their operands in parallel
+    vector<pair<int,Operand>> copies;
+    for(auto& instr: func.blocks[succ].instrs){
+        if(instr.op != OP_PHI){
+            break;
+        }
+        for(int i = 0; i < instr.extra_count; i += 2){
+            const Operand& src = func.extra[instr.extra_begin + i];
+            if(func.extra[instr.extra_begin + i + 1].id == block && !(src.kind == OPND_VALUE && loc(src.id) == loc(instr.dst))){
+                copies.push_back({instr.dst, src});
+            }
+        }
+    }
+
+    bool overlap = false;
+    for(auto& dst: copies){
+        for(auto& src: copies){
+            if(src.second.kind == OPND_VALUE && loc(src.second.id) == loc(dst.first)){
+                overlap = true;
+            }
+        }
+    }
+    if(!overlap){
+        for(auto& copy: copies){
+            int reg = reg_of[copy.first] != NO_REG ? reg_of[copy.first] : RAX;
+            loadTo(copy.second, reg);
+            storeFrom(reg, copy.first);
+        }
+    } else {
+        for(size_t i = 0; i < copies.size(); i++){
+            loadTo(copies[i].second, RAX);
+            os << "\tmovq %rax, " << temp_slots[i] << "(%rbp)\n";
+        }
+        for(size_t i = 0; i < copies.size(); i++){
+            os << "\tmovq " << temp_slots[i] << "(%rbp), %rax\n";
+            storeFrom(RAX, copies[i].first);
+        }
+    }
+
+    if(succ != block + 1){
+        os << "\tjmp " << label(succ) << "\n";
+    }
+}
+
+void AsmFunction::emitLeave(){
+    os << "\tleaq " << -8 * int(saved_regs.size()) << "(%rbp), %rsp\n";
+    for(auto reg = saved_regs.rbegin(); reg != saved_regs.rend(); ++reg){
+        os << "\tpopq " << reg64[*reg] << "\n";
+    }
+    os << "\tpopq %rbp\n";
+}
+
+void AsmFunction::emitInstr(int block, const Instr& instr){
+    switch(instr.op){
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_AND:
+        case OP_OR:
+        case OP_XOR: {
+            // computed in the result's register unless the second operand lives there
+            int reg = reg_of[instr.dst];
+            if(reg == NO_REG || (instr.ops[1].kind == OPND_VALUE && reg_of[instr.ops[1].id] == reg)){
+                reg = RAX;
+            }
+            loadTo(instr.ops[0], reg);
+            // i1 values are kept as 0 or 1, which the logic operations preserve
+            const char* mnemonic = instr.op == OP_ADD ? "addl " : instr.op == OP_SUB ? "subl " : instr.op == OP_MUL ? "imull " :
+                                   instr.op == OP_AND ? "andl " : instr.op == OP_OR ? "orl " : "xorl ";
+            os << "\t" << mnemonic << opnd(instr.ops[1]) << ", " << reg32[reg] << "\n";
+            if(instr.type == IR_I8){
+                os << "\tmovzbl " << reg8[reg] << ", " << reg32[reg] << "\n";
+            }
+            storeFrom(reg, instr.dst);
+            break;
+        }
+        case OP_SDIV:
+        case OP_UDIV:
+            loadTo(instr.ops[0], RAX);
+            loadTo(instr.ops[1], RCX);
+            os << (instr.op == OP_SDIV ? "\tcltd\n\tidivl %ecx\n" : "\txorl %edx, %edx\n\tdivl %ecx\n");
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_ICMP:
+            loadTo(instr.ops[0], RAX);
+            loadTo(instr.ops[1], RCX);
+            // i8 predicates are signed, compare the low bytes
+            os << (instr.ops[0].type == IR_I8 ? "\tcmpb %cl, %al\n" : "\tcmpl %ecx, %eax\n");
+            os << "\t" << setcc(instr.pred) << " %al\n\tmovzbl %al, %eax\n";
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_ZEXT:
+            // narrow values are kept zero extended
+            loadTo(instr.ops[0], RAX);
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_TRUNC:
+            loadTo(instr.ops[0], RAX);
+            os << (instr.type == IR_I1 ? "\tandl $1, %eax\n" : "\tmovzbl %al, %eax\n");
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_ALLOCA:
+            os << "\tleaq " << storage_of[instr.dst] << "(%rbp), %rax\n";
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_GEP:
+            loadTo(instr.ops[0], RAX);
+            if(instr.ops[1].kind == OPND_CONST){
+                os << "\tleaq " << instr.ops[1].id * elementSize(instr.type) << "(%rax), %rax\n";
+            } else {
+                loadTo(instr.ops[1], RCX);
+                os << "\tmovslq %ecx, %rcx\n\tleaq (%rax,%rcx," << elementSize(instr.type) << "), %rax\n";
+            }
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_LOAD:
+            loadTo(instr.ops[0], RAX);
+            os << (instr.type == IR_I32 ? "\tmovl (%rax), %eax\n" : "\tmovzbl (%rax), %eax\n");
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_STORE:
+            loadTo(instr.ops[1], RAX);
+            loadTo(instr.ops[0], RCX);
+            os << (instr.type == IR_I32 ? "\tmovl %ecx, (%rax)\n" : "\tmovb %cl, (%rax)\n");
+            break;
+        case OP_STR_PTR:
+            os << "\tleaq .Ls" << instr.ops[0].id << "(%rip), %rax\n";
+            storeFrom(RAX, instr.dst);
+            break;
+        case OP_CALL: {
+            // stack arguments go first, padded to keep rsp aligned. the register arguments are staged
+            // on the stack too, so loading one never overwrites the source of another
+            int num_args = instr.extra_count;
+            int num_stack = max(0, num_args - NUM_ARG_REGS);
+            int pad = num_stack % 2 ? 8 : 0;
+            if(pad){
+                os << "\tsubq $8, %rsp\n";
+            }
+            for(int i = num_args - 1; i >= 0; i--){
+                loadTo(func.extra[instr.extra_begin + i], RAX);
+                os << "\tpushq %rax\n";
+            }
+            for(int i = 0; i < min(num_args, NUM_ARG_REGS); i++){
+                os << "\tpopq " << reg64[arg_regs[i]] << "\n";
+            }
+            if(instr.tail && !num_stack && name != "main"){
+                // the callee returns to our caller, the ret following the call isn't reached
+                emitLeave();
+                os << "\tjmp " << NamePool::instance().str(instr.ops[0].id) << "\n";
+                break;
+            }
+            os << "\tcall " << NamePool::instance().str(instr.ops[0].id) << "\n";
+            if(num_stack || pad){
+                os << "\taddq $" << 8 * num_stack + pad << ", %rsp\n";
+            }
+            if(instr.dst >= 0){
+                storeFrom(RAX, instr.dst);
+            }
+            break;
+        }
+        case OP_PHI:
+            break; // copied on the incoming edges
+        case OP_BR:
+            emitEdge(block, instr.ops[0].id);
+            break;
+        case OP_COND_BR:
+            if(instr.ops[0].kind == OPND_CONST){
+                emitEdge(block, instr.ops[0].id ? instr.ops[1].id : instr.ops[2].id);
+                break;
+            }
+            loadTo(instr.ops[0], RAX);
+            os << "\ttestl %eax, %eax\n\tje " << label(block) << "_false\n";
+            emitEdge(block, instr.ops[1].id);
+            if(instr.ops[1].id == block + 1){
+                os << "\tjmp " << label(block + 1) << "\n";
+            }
+            os << label(block) << "_false:\n";
+            emitEdge(block, instr.ops[2].id);
+            break;
+        case OP_RET:
+            if(instr.ops[0].kind != OPND_NONE){
+                loadTo(instr.ops[0], RAX);
+            } else if(name == "main"){
+                os << "\txorl %eax, %eax\n"; // exit status for the C startup code
+            }
+            os << "\tjmp .L" << name << "_ret\n";
+            break;
+        case OP_UNREACHABLE:
+            os << "\tud2\n";
+            break;
+    }
+}
+
+void AsmFunction::emit(){
+    computeIntervals();
+    allocateRegisters();
+    layoutFrame();
+
+    os << "\t.text\n\t.globl " << name << "\n\t.type " << name << ", @function\n" << name << ":\n";
+    os << "\tpushq %rbp\n\tmovq %rsp, %rbp\n";
+    for(Reg reg: saved_regs){
+        os << "\tpushq " << reg64[reg] << "\n";
+    }
+    if(frame_bytes){
+        os << "\tsubq $" << frame_bytes << ", %rsp\n";
+    }
+
+    // the arguments are kept in the frame, narrow ones zero extended
+    for(size_t arg = 1; arg < arg_slot.size(); arg++){
+        IRType type = func.arg_types[arg - 1];
+        if(arg <= size_t(NUM_ARG_REGS)){
+            int reg = arg_regs[arg - 1];
+            if(type == IR_I8){
+                os << "\tmovzbl " << reg8[reg] << ", %eax\n";
+            } else if(type == IR_I1){
+                os << "\tmovl " << reg32[reg] << ", %eax\n\tandl $1, %eax\n";
+            } else {
+                os << "\tmov" << suffix(type) << " " << regName(reg, type) << ", " << regName(RAX, type) << "\n";
+            }
+        } else {
+            os << "\tmovq " << 16 + 8 * (arg - NUM_ARG_REGS - 1) << "(%rbp), %rax\n";
+        }
+        os << "\tmovq %rax, " << arg_slot[arg] << "(%rbp)\n";
+    }
+
+    for(int block = 0; block < num_blocks; block++){
+        os << label(block) << ":\n";
+        for(auto& instr: func.blocks[block].instrs){
+            emitInstr(block, instr);
+        }
+    }
+
+    os << ".L" << name << "_ret:\n";
+    emitLeave();
+    os << "\tret\n\t.size " << name << ", .-" << name << "\n\n";
+}
+
+}
+
+void printAsmRuntime(ostream& os){
+    os << "# runtime: print0 and printi0 append lines to a buffer that is written to fd 1 with the write syscall\n"
+          "# when full, at exit (from .fini_array) and by divByZero before it exits\n"
+          "\t.text\n"
+          "printi0:\n"
+          "\t# the digits are formatted backwards, ending with the newline at 23(%rsp)\n"
+          "\tsubq $24, %rsp\n"
+          "\tleaq 23(%rsp), %rsi\n"
+          "\tmovb $10, (%rsi)\n"
+          "\tmovl %edi, %eax\n"
+          "\ttestl %eax, %eax\n"
+          "\tjns 1f\n"
+          "\tnegl %eax\n"
+          "1:\n"
+          "\tmovl $10, %ecx\n"
+          "2:\n"
+          "\txorl %edx, %edx\n"
+          "\tdivl %ecx\n"
+          "\taddb $48, %dl\n"
+          "\tdecq %rsi\n"
+          "\tmovb %dl, (%rsi)\n"
+          "\ttestl %eax, %eax\n"
+          "\tjnz 2b\n"
+          "\ttestl %edi, %edi\n"
+          "\tjns 3f\n"
+          "\tdecq %rsi\n"
+          "\tmovb $45, (%rsi)\n"
+          "3:\n"
+          "\tleaq 24(%rsp), %rdx\n"
+          "\tsubq %rsi, %rdx\n"
+          "\tcall .Lappend\n"
+          "\taddq $24, %rsp\n"
+          "\tret\n"
+          "\n"
+          "print0:\n"
+          "\tmovq %rdi, %rsi\n"
+          "\tmovq %rdi, %rdx\n"
+          "1:\n"
+          "\tcmpb $0, (%rdx)\n"
+          "\tje 2f\n"
+          "\tincq %rdx\n"
+          "\tjmp 1b\n"
+          "2:\n"
+          "\tsubq %rsi, %rdx\n"
+          "\tcall .Lappend\n"
+          "\tleaq .Lnewline(%rip), %rsi\n"
+          "\tmovl $1, %edx\n"
+          "\tjmp .Lappend\n"
+          "\n"
+          "divByZero:\n"
+          "\tleaq .Lzero_error(%rip), %rdi\n"
+          "\tcall print0\n"
+          "\tcall .Lflush\n"
+          "\txorl %edi, %edi\n"
+          "\tmovl $231, %eax # exit_group\n"
+          "\tsyscall\n"
+          "\n"
+          "# appends the rdx bytes at rsi to the buffer, flushing it first if they don't fit.\n"
+          "# bytes that don't fit in an empty buffer either are written directly\n"
+          ".Lappend:\n"
+          "\tmovq .Lout_len(%rip), %rax\n"
+          "\tleaq (%rax,%rdx), %rcx\n"
+          "\tcmpq $65536, %rcx\n"
+          "\tjbe 1f\n"
+          "\tpushq %rsi\n"
+          "\tpushq %rdx\n"
+          "\tcall .Lflush\n"
+          "\tpopq %rdx\n"
+          "\tpopq %rsi\n"
+          "\txorl %eax, %eax\n"
+          "\tcmpq $65536, %rdx\n"
+          "\tja .Lwrite_all\n"
+          "1:\n"
+          "\tleaq .Lout_buf(%rip), %rdi\n"
+          "\taddq %rax, %rdi\n"
+          "\taddq %rdx, %rax\n"
+          "\tmovq %rax, .Lout_len(%rip)\n"
+          "\tmovq %rdx, %rcx\n"
+          "\trep movsb\n"
+          "\tret\n"
+          "\n"
+          ".Lflush:\n"
+          "\tleaq .Lout_buf(%rip), %rsi\n"
+          "\tmovq .Lout_len(%rip), %rdx\n"
+          "\tmovq $0, .Lout_len(%rip)\n"
+          "# writes the rdx bytes at rsi, retrying short writes\n"
+          ".Lwrite_all:\n"
+          "\ttestq %rdx, %rdx\n"
+          "\tjle 1f\n"
+          "\tmovl $1, %edi\n"
+          "\tmovl $1, %eax\n"
+          "\tsyscall\n"
+          "\ttestq %rax, %rax\n"
+          "\tjle 1f\n"
+          "\taddq %rax, %rsi\n"
+          "\tsubq %rax, %rdx\n"
+          "\tjmp .Lwrite_all\n"
+          "1:\n"
+          "\tret\n"
+          "\n"
+          "\t.section .fini_array, \"aw\"\n"
+          "\t.align 8\n"
+          "\t.quad .Lflush\n"
+          "\n"
+          "\t.section .rodata\n"
+          ".Lzero_error:\n"
+          "\t.asciz \"Error division by zero\"\n"
+          ".Lnewline:\n"
+          "\t.byte 10\n"
+          "\n"
+          "\t.bss\n"
+          "\t.align 8\n"
+          ".Lout_len:\n"
+          "\t.zero 8\n"
+          ".Lout_buf:\n"
+          "\t.zero 65536\n"
+          "\n";
+}
+
+void printAsmFunction(ostream& os, const IRFunction& func){
+    AsmFunction(os, func).emit();
+}
+
+void printAsmStrings(ostream& os, const IRStrings& strings){
+    os << "\t.section .rodata\n";
+    for(size_t i = 0; i < strings.literals.size(); i++){
+        // the literal is in LLVM c"..." syntax, where \XX is a hex escaped byte
+        const string& literal = strings.literals[i];
+        os << ".Ls" << i << ":\n\t.byte ";
+        for(size_t c = 0; c < literal.size(); c++){
+            int byte = (unsigned char)literal[c];
+            if(literal[c] == '\\' && c + 2 < literal.size() && isxdigit(literal[c + 1]) && isxdigit(literal[c + 2])){
+                byte = stoi(literal.substr(c + 1, 2), nullptr, 16);
+                c += 2;
+            }
+            os << byte << ",";
+        }
+        os << "0\n";
+    }
+    os << "\t.section .note.GNU-stack,\"\",@progbits\n";
+}
@@ -0,0 +1,18 @@
+#ifndef HW5_X86_H
+#define HW5_X86_H
+
+#include "IR.hpp"
+
+// x86-64 backend: lowers complete IRFunctions to GNU assembler (AT&T syntax) for the System V ABI.
+// the output is a self-contained program, `cc program.s -o program` links it without any LLVM tools
+
+//the runtime the program calls (print0, printi0, divByZero), written with plain write/exit syscalls
+void printAsmRuntime(ostream& os);
+
+//lowers one function, allocating its values to registers with linear scan
+void printAsmFunction(ostream& os, const IRFunction& func);
+
+//the string literals, as read-only data
+void printAsmStrings(ostream& os, const IRStrings& strings);
+
+#endif //HW5_X86_H
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include "bp.hpp"
+#include "NamePool.hpp"
 
 enum Type {
     STRING_TYPE = 0,
@@ -13,26 +14,40 @@ enum Type {
     VOID_TYPE = 4,
 };
 
-class ArgInfo {
+// semantic values are owned by the arena of the function being parsed
+
+class ArgInfo : public ArenaObject<ArgInfo> {
 public:
-    string arg_name;
+    NameId arg_name;
     Type arg_type;
     int arg_line;
 };
 
-class ExpInfo {
+class ExpInfo : public ArenaObject<ExpInfo> {
 public:
     Type type;
-    string place;
-    vector<pair<int,BranchLabelIndex>> truelist;
-    vector<pair<int,BranchLabelIndex>> falselist;
+    Operand place;
+    // a bool is an i1 value in place, or jumping code whose branches are in truelist and falselist.
+    // only conditions and the short circuit of and/or around an operand with side effects jump
+    bool jumping = false;
+    PatchList truelist;
+    PatchList falselist;
+    // constant lattice value: either known at compile time (const_val, bytes kept in 0..255, bools as 0/1)
+    // or only at run time. a known expression emits no code, its place is the constant operand
+    bool is_const = false;
+    int const_val = 0;
+    // evaluating it calls a function or may fail a division, so the short circuit of and/or must skip it
+    bool has_side_effects = false;
 };
 
-class StatementInfo {
+class StatementInfo : public ArenaObject<StatementInfo> {
 public:
-    vector<pair<int,BranchLabelIndex>> nextlist;
-    vector<pair<int,BranchLabelIndex>> breaklist;
-    vector<pair<int,BranchLabelIndex>> continuelist;
+    PatchList nextlist;
+    PatchList breaklist;
+    PatchList continuelist;
 };
 
+typedef ArenaVector<ArgInfo*> ArgList;
+typedef ArenaVector<ExpInfo*> ExpList;
+
 #endif //HW3_ATTRIBUTES_H
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Compile-time benchmark: times hw5 on generated programs of every shape at growing sizes.
+
+    compile_bench.py [--sizes 2000,8000,32000] [--shapes andor,loops] [--json results.json] [hw5]
+
+For each program it reports the lines per second and the peak RSS of the compiler, from its own
+--time-report=json. A shape whose lines per second drop as its size grows has a superlinear path.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import gen
+
+
+def runOnce(hw5, path):
+    with open(path) as program:
+        start = time.perf_counter()
+        proc = subprocess.run([hw5, "--time-report=json"], stdin=program, stdout=subprocess.PIPE,
+                              stderr=subprocess.PIPE)
+        wall = time.perf_counter() - start
+    if proc.returncode != 0 or proc.stdout.startswith(b"line "):
+        raise RuntimeError("{} failed on {}: {}".format(hw5, path, proc.stdout[:200] + proc.stderr[:200]))
+    report = json.loads(proc.stderr.decode().strip().splitlines()[-1])
+    return wall, report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hw5", nargs="?", default="./hw5")
+    parser.add_argument("--sizes", default="2000,8000,32000", help="program sizes in lines, comma separated")
+    parser.add_argument("--shapes", default=",".join(sorted(gen.SHAPES)), help="shapes to run, comma separated")
+    parser.add_argument("--runs", type=int, default=3, help="runs per program, the fastest counts")
+    parser.add_argument("--json", help="also write the results to this file")
+    args = parser.parse_args()
+
+    sizes = [int(size) for size in args.sizes.split(",")]
+    results = []
+    print("{:<10} {:>8} {:>8} {:>10} {:>12} {:>9} {:>10}".format(
+        "shape", "size", "lines", "seconds", "lines/s", "rss MB", "vs first"))
+    with tempfile.TemporaryDirectory() as tmp:
+        for shape in args.shapes.split(","):
+            first_rate = None
+            for size in sizes:
+                path = os.path.join(tmp, "{}_{}.in".format(shape, size))
+                source = gen.generate(shape, size)
+                with open(path, "w") as program:
+                    program.write(source)
+                lines = source.count("\n")
+                runs = [runOnce(args.hw5, path) for _ in range(args.runs)]
+                wall, report = min(runs, key=lambda run: run[0])
+                rate = lines / wall
+                first_rate = first_rate or rate
+                rss_mb = report["counters"]["peak_rss_kb"] / 1024.0
+                print("{:<10} {:>8} {:>8} {:>10.4f} {:>12.0f} {:>9.1f} {:>9.2f}x".format(
+                    shape, size, lines, wall, rate, rss_mb, rate / first_rate))
+                sys.stdout.flush()
+                results.append({"shape": shape, "size": size, "lines": lines, "seconds": wall,
+                                "lines_per_second": rate, "peak_rss_kb": report["counters"]["peak_rss_kb"],
+                                "report": report})
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump(results, out, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Generates large programs of a given shape, to benchmark the compiler.
+
+    gen.py SHAPE SIZE > program.in
+
+SIZE is roughly the number of lines of the program. The shapes stress one part of the compiler each:
+
+    andor      one boolean expression of SIZE and/or terms (backpatch lists, the parser stack)
+    overloads  SIZE overloads of one function, each called once (overload resolution)
+    loops      functions of deeply nested whiles with ifs, breaks and continues (scopes, jumps)
+    strings    SIZE prints of distinct string literals (the string table)
+
+Every program is valid, so the whole pipeline runs on it.
+"""
+
+import sys
+
+# nesting depth of a loop nest, one local variable per level
+LOOP_DEPTH = 30
+# statements per function, so that no single function dominates the shapes that don't need it
+FUNC_LINES = 500
+
+
+def andor(size):
+    lines = ["void main() {",
+             "    int x = 3;",
+             "    int y = 4;",
+             "    bool c = true;",
+             "    bool r = x < 1"]
+    ops = ["and", "or"]
+    terms = ["y > {k}", "not c", "x == {k}", "c", "x + y <= {k}"]
+    for k in range(size):
+        term = terms[k % len(terms)].format(k=k % 100)
+        lines.append("        {} {}".format(ops[(k // 3) % 2], term))
+    lines[-1] += ";"
+    lines += ["    if (r) print(\"true\"); else print(\"false\");", "}"]
+    return lines
+
+
+def signatures(count):
+    # distinct tuples of int and bool, shortest first: a call with exactly these types matches only one
+    # overload, while byte arguments could also match an int parameter and make the call ambiguous
+    length = 1
+    while count > 0:
+        for bits in range(min(count, 1 << length)):
+            yield ["bool" if bits >> i & 1 else "int" for i in range(length)]
+        count -= 1 << length
+        length += 1
+
+
+def overloads(size):
+    lines = []
+    calls = []
+    for types in signatures(size):
+        params = ", ".join("{} a{}".format(t, i) for i, t in enumerate(types))
+        lines.append("override int f({}) {{ return {}; }}".format(params, len(types)))
+        args = ", ".join("true" if t == "bool" else str(i) for i, t in enumerate(types))
+        calls.append("    s = s + f({});".format(args))
+    # the calls are split over functions, each resolved against every overload
+    for start in range(0, len(calls), FUNC_LINES):
+        lines.append("int calls{}() {{".format(start // FUNC_LINES))
+        lines.append("    int s = 0;")
+        lines += calls[start:start + FUNC_LINES]
+        lines += ["    return s;", "}"]
+    lines.append("void main() {")
+    for start in range(0, len(calls), FUNC_LINES):
+        lines.append("    printi(calls{}());".format(start // FUNC_LINES))
+    lines.append("}")
+    return lines
+
+
+def loopNest(depth, indent):
+    pad = "    " * indent
+    if depth == LOOP_DEPTH:
+        return [pad + "total = total + 1;"]
+    var = "i{}".format(depth)
+    outer = "i{}".format(depth - 1) if depth > 0 else "total"
+    return [pad + "int {} = 0;".format(var),
+            pad + "while ({} < 1) {{".format(var),
+            pad + "    {v} = {v} + 1;".format(v=var),
+            pad + "    if ({} == 1 and {} > 1000) continue;".format(var, outer),
+            pad + "    if ({} > 1000000) break;".format(outer)] + \
+        loopNest(depth + 1, indent + 1) + \
+        [pad + "}"]
+
+
+def loops(size):
+    nest = loopNest(0, 1)
+    count = max(1, size // (len(nest) + 4))
+    lines = []
+    for k in range(count):
+        lines += ["int loops{}() {{".format(k), "    int total = 0;"] + nest + ["    return total;", "}"]
+    lines.append("void main() {")
+    lines += ["    printi(loops{}());".format(k) for k in range(count)]
+    lines.append("}")
+    return lines
+
+
+def strings(size):
+    lines = []
+    funcs = 0
+    for start in range(0, size, FUNC_LINES):
+        lines.append("void strings{}() {{".format(funcs))
+        for k in range(start, min(size, start + FUNC_LINES)):
+            lines.append("    print(\"string literal number {} of the table\");".format(k))
+        lines.append("}")
+        funcs += 1
+    lines.append("void main() {")
+    lines += ["    strings{}();".format(k) for k in range(funcs)]
+    lines.append("}")
+    return lines
+
+
+SHAPES = {"andor": andor, "overloads": overloads, "loops": loops, "strings": strings}
+
+
+def generate(shape, size):
+    return "\n".join(SHAPES[shape](size)) + "\n"
+
+
+def main():
+    if len(sys.argv) != 3 or sys.argv[1] not in SHAPES or not sys.argv[2].isdigit():
+        sys.stderr.write("usage: {} {{{}}} size\n".format(sys.argv[0], "|".join(sorted(SHAPES))))
+        return 1
+    sys.stdout.write(generate(sys.argv[1], int(sys.argv[2])))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+"""Runtime benchmark: how fast the code hw5 generates runs.
+
+    run_bench.py [--runners lli,llc,asm] [--runs 3] [--json results.json] [hw5] [program.in ...]
+
+Every program (bench/programs/*.in by default) is compiled by hw5 and run
+
+    lli   the LLVM IR through lli
+    llc   the LLVM IR through llc -O2 and $CC (cc by default) into an executable
+    asm   the x86-64 assembly of hw5 --asm through $CC into an executable
+
+reporting the fastest wall time of --runs runs, the instructions executed (from perf stat, when perf is
+installed) and the static size of the code: IR instructions for lli, machine instructions for llc and asm.
+The outputs of the runners must agree, a program whose outputs differ is reported and fails the run.
+"""
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+RUNNERS = ["lli", "llc", "asm"]
+
+
+def check(cmd, **kwargs):
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, **kwargs)
+    if proc.returncode != 0:
+        raise RuntimeError("{} failed: {}".format(" ".join(cmd), proc.stderr.decode()[:500]))
+    return proc.stdout
+
+
+def irInstructions(path):
+    # the lines of function bodies that aren't labels or braces
+    count = 0
+    in_func = False
+    with open(path) as code:
+        for line in code:
+            if line.startswith("define "):
+                in_func = True
+            elif line.startswith("}"):
+                in_func = False
+            elif in_func and line.strip() and not line.rstrip().endswith(":"):
+                count += 1
+    return count
+
+
+def machineInstructions(path):
+    # indented lines that aren't directives or labels
+    count = 0
+    with open(path) as code:
+        for line in code:
+            text = line.split("#")[0].strip()
+            if line[:1] in (" ", "\t") and text and not text.startswith(".") and not text.endswith(":"):
+                count += 1
+    return count
+
+
+def runTimed(cmd, runs, perf):
+    # returns the output, the fastest wall time and the instructions executed (None without perf)
+    best = None
+    output = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        wall = time.perf_counter() - start
+        best = wall if best is None else min(best, wall)
+        output = proc.stdout
+    instructions = None
+    if perf:
+        proc = subprocess.run([perf, "stat", "-x", ",", "-e", "instructions:u", "--"] + cmd,
+                              stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        for line in proc.stderr.decode().splitlines():
+            fields = line.split(",")
+            if len(fields) > 2 and fields[2].startswith("instructions") and fields[0].isdigit():
+                instructions = int(fields[0])
+    return output, best, instructions
+
+
+def build(runner, hw5, program, work, cc):
+    # returns the command that runs the program, and its static instruction count
+    stem = os.path.join(work, os.path.splitext(os.path.basename(program))[0])
+    with open(program) as source:
+        if runner == "asm":
+            code = check([hw5, "--asm"], stdin=source)
+        else:
+            code = check([hw5], stdin=source)
+    if code.startswith(b"line "):
+        raise RuntimeError("{}: {}".format(program, code.decode().strip()))
+    if runner == "lli":
+        with open(stem + ".ll", "wb") as out:
+            out.write(code)
+        return ["lli", stem + ".ll"], irInstructions(stem + ".ll")
+    if runner == "llc":
+        with open(stem + ".ll", "wb") as out:
+            out.write(code)
+        check(["llc", "-O2", "-relocation-model=pic", stem + ".ll", "-o", stem + ".llc.s"])
+        check([cc, stem + ".llc.s", "-o", stem + ".llc"])
+        return [stem + ".llc"], machineInstructions(stem + ".llc.s")
+    with open(stem + ".s", "wb") as out:
+        out.write(code)
+    check([cc, stem + ".s", "-o", stem + ".asm"])
+    return [stem + ".asm"], machineInstructions(stem + ".s")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hw5", nargs="?", default="./hw5")
+    parser.add_argument("programs", nargs="*")
+    parser.add_argument("--runners", default=",".join(RUNNERS), help="runners to use, comma separated")
+    parser.add_argument("--runs", type=int, default=3, help="runs per program, the fastest counts")
+    parser.add_argument("--json", help="also write the results to this file")
+    args = parser.parse_args()
+
+    programs = args.programs or sorted(glob.glob(os.path.join(BENCH_DIR, "programs", "*.in")))
+    runners = args.runners.split(",")
+    cc = os.environ.get("CC", "cc")
+    perf = shutil.which("perf")
+    if not perf:
+        print("perf not found, instructions executed are not counted")
+
+    results = []
+    mismatches = []
+    print("{:<12} {:<5} {:>10} {:>16} {:>8}".format("program", "run", "seconds", "instructions", "static"))
+    with tempfile.TemporaryDirectory() as work:
+        for program in programs:
+            name = os.path.splitext(os.path.basename(program))[0]
+            outputs = {}
+            for runner in runners:
+                cmd, static = build(runner, args.hw5, program, work, cc)
+                output, wall, instructions = runTimed(cmd, args.runs, perf)
+                outputs[runner] = output
+                print("{:<12} {:<5} {:>10.4f} {:>16} {:>8}".format(
+                    name, runner, wall, instructions if instructions is not None else "-", static))
+                sys.stdout.flush()
+                results.append({"program": name, "runner": runner, "seconds": wall,
+                                "instructions": instructions, "static_instructions": static})
+            if len(set(outputs.values())) > 1:
+                mismatches.append(name)
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump(results, out, indent=2)
+    if mismatches:
+        print("outputs differ between runners: " + ", ".join(mismatches))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,21 +1,26 @@
 #include "bison_code.hpp"
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 
-void initSymTable(SymTable* symbol_table, vector<string>& predefined_func){
-    symbol_table->addFuncSymbol(predefined_func[0].c_str(), VOID_TYPE, {STRING_TYPE}, false, 0);
-    symbol_table->addFuncSymbol(predefined_func[1].c_str(), VOID_TYPE, {INT_TYPE}, false, 0);
+int lineno(){
+    return Compiler::current().lineno();
+}
+
+void initSymTable(SymTable* symbol_table, vector<NameId>& predefined_func){
+    symbol_table->addFuncSymbol(predefined_func[0], VOID_TYPE, {STRING_TYPE}, false, 0);
+    symbol_table->addFuncSymbol(predefined_func[1], VOID_TYPE, {INT_TYPE}, false, 0);
 }
 
 void checkMain(SymTable* symbol_table){
-    string name = "main";
-    vector<SymTableEntry*> matches = symbol_table->getFuncSymbol(name.c_str(), {});
+    NameId name = NamePool::instance().intern("main");
+    vector<SymTableEntry*> matches = symbol_table->getFuncSymbol(name, {});
 
     // change conditions for error according to staff
     if(matches.empty() || matches[0]->type != VOID_TYPE){
         output::errorMainMissing();
-        exit(0);
+        abortCompilation();
     }
 }
 
@@ -25,8 +30,8 @@ bool isNumeric(Type type){
 
 Type checkIfBool(Type type){
     if(type != BOOL_TYPE) {
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 
     return BOOL_TYPE;
@@ -34,8 +39,8 @@ Type checkIfBool(Type type){
 
 Type checkByteVal(int val){
     if(val > 255){
-        output::errorByteTooLarge(yylineno, to_string(val));
-        exit(0);
+        output::errorByteTooLarge(lineno(), to_string(val));
+        abortCompilation();
     }
 
     return BYTE_TYPE;
@@ -43,8 +48,8 @@ Type checkByteVal(int val){
 
 Type checkBinopExp(Type type1, Type type2){
     if(!isNumeric(type1) || !isNumeric(type2)){
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
     if(type1 == INT_TYPE || type2 == INT_TYPE){
         return INT_TYPE;
@@ -55,8 +60,8 @@ Type checkBinopExp(Type type1, Type type2){
 
 Type checkRelopExp(Type type1, Type type2){
     if(!isNumeric(type1) || !isNumeric(type2)) {
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 
     return BOOL_TYPE;
@@ -71,59 +76,59 @@ Type checkLogicExp(Type type1, Type type2){
 Type checkConversion(Type target_type, Type type){
     bool is_legal = isNumeric(target_type) && isNumeric(type);
     if(!is_legal){
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 
     return target_type;
 }
 
-Type checkVarDeclaredBeforeUsed(SymTable* symbol_table, const char* name){
+Type checkVarDeclaredBeforeUsed(SymTable* symbol_table, NameId name){
     SymTableEntry* symbol = symbol_table->getVarSymbol(name);
     if(!symbol){
-        output::errorUndef(yylineno, string(name));
-        exit(0);
+        output::errorUndef(lineno(), nameStr(name));
+        abortCompilation();
     }
 
     return symbol->type;
 }
 
-void checkVarNotDeclared(SymTable* symbol_table, const char* name){
+void checkVarNotDeclared(SymTable* symbol_table, NameId name){
     if(symbol_table->getVarSymbol(name) || !symbol_table->getFuncsByName(name).empty()){
-        output::errorDef(yylineno, string(name));
-        exit(0);
+        output::errorDef(lineno(), nameStr(name));
+        abortCompilation();
     }
 }
 
-void checkAssign(const char* id_name, Type id_type, Type exp_type){
+void checkAssign(NameId id_name, Type id_type, Type exp_type){
     bool is_legal = (id_type == exp_type) || (id_type == INT_TYPE && exp_type == BYTE_TYPE);
     if(!is_legal){
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 }
 
-void handleVarDec(SymTable* symbol_table, const char* name, Type type){
+void handleVarDec(SymTable* symbol_table, NameId name, Type type){
     checkVarNotDeclared(symbol_table, name);
     symbol_table->addVarSymbol(name, type);
 }
 
-void handleVarInitialization(SymTable* symbol_table, const char* name, Type type, Type exp_type){
+void handleVarInitialization(SymTable* symbol_table, NameId name, Type type, Type exp_type){
     checkVarNotDeclared(symbol_table, name);
     checkAssign(name, type, exp_type);
     symbol_table->addVarSymbol(name, type);
 }
 
-void handleVarReassign(SymTable* symbol_table, const char* name, Type exp_type){
+void handleVarReassign(SymTable* symbol_table, NameId name, Type exp_type){
     Type id_type = checkVarDeclaredBeforeUsed(symbol_table, name);
     checkAssign(name, id_type, exp_type);
 }
 
-SymTableEntry* checkIfLegalCall(SymTable* symbol_table, const char* func_name, vector<ExpInfo*>* args){
+SymTableEntry* checkIfLegalCall(SymTable* symbol_table, NameId func_name, ExpList* args){
     vector<SymTableEntry*> matches = symbol_table->getFuncsByName(func_name);
     if(matches.empty()) {
-        output::errorUndefFunc(yylineno, string(func_name));
-        exit(0);
+        output::errorUndefFunc(lineno(), nameStr(func_name));
+        abortCompilation();
     }
 
     vector<Type> arg_types;
@@ -135,13 +140,13 @@ SymTableEntry* checkIfLegalCall(SymTable* symbol_table, const char* func_name, v
     vector<SymTableEntry*> candidates = symbol_table->getFuncSymbol(func_name, arg_types);
 
     if(candidates.empty()) {
-        output::errorPrototypeMismatch(yylineno, string(func_name));
-        exit(0);
+        output::errorPrototypeMismatch(lineno(), nameStr(func_name));
+        abortCompilation();
     }
     // new ambiguous rule
     if(candidates.size() > 1){
-        output::errorAmbiguousCall(yylineno, string(func_name));
-        exit(0);
+        output::errorAmbiguousCall(lineno(), nameStr(func_name));
+        abortCompilation();
     }
 
     return candidates[0];
@@ -149,39 +154,39 @@ SymTableEntry* checkIfLegalCall(SymTable* symbol_table, const char* func_name, v
 
 void checkBreakInWhile(vector<bool>& in_while){
     if(in_while.empty()){
-        output::errorUnexpectedBreak(yylineno);
-        exit(0);
+        output::errorUnexpectedBreak(lineno());
+        abortCompilation();
     }
 }
 
 void checkContinueInWhile(vector<bool>& in_while){
     if(in_while.empty()){
-        output::errorUnexpectedContinue(yylineno);
-        exit(0);
+        output::errorUnexpectedContinue(lineno());
+        abortCompilation();
     }
 }
 
 void checkEmptyRet(Type last_ret_type){
     if(last_ret_type != VOID_TYPE){
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 }
 
 void checkExpRet(Type last_ret_type, Type exp_type){
     if(last_ret_type == VOID_TYPE){
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 
     bool is_legal = last_ret_type == exp_type || (last_ret_type == INT_TYPE && exp_type == BYTE_TYPE);
     if(!is_legal){
-        output::errorMismatch(yylineno);
-        exit(0);
+        output::errorMismatch(lineno());
+        abortCompilation();
     }
 }
 
-bool checkFormalRedef(vector<string>& arg_names, string& new_arg_name){
+bool checkFormalRedef(vector<NameId>& arg_names, NameId new_arg_name){
     for(auto& past_arg_name: arg_names){
         if(past_arg_name == new_arg_name){
             return true;
@@ -190,26 +195,26 @@ bool checkFormalRedef(vector<string>& arg_names, string& new_arg_name){
     return false;
 }
 
-int addFunc(SymTable* symbol_table, const char* func_name, Type ret_type, vector<ArgInfo*>* arg_list, bool is_override){
+int addFunc(SymTable* symbol_table, NameId func_name, Type ret_type, ArgList* arg_list, bool is_override){
     // check if a variable already exists with the same name
     if(symbol_table->getVarSymbol(func_name)){
-        output::errorDef(yylineno, string(func_name));
-        exit(0);
+        output::errorDef(lineno(), nameStr(func_name));
+        abortCompilation();
     }
     // change conditions according to staff
-    if(string(func_name) == "main" && is_override){
-        output::errorMainOverride(yylineno);
-        exit(0);
+    if(nameStr(func_name) == "main" && is_override){
+        output::errorMainOverride(lineno());
+        abortCompilation();
     }
 
     vector<Type> arg_types;
-    vector<string> arg_names;
+    vector<NameId> arg_names;
 
     if(arg_list){
         for(auto& arg_info: *arg_list){
-            if(symbol_table->getVarSymbol(arg_info->arg_name.c_str()) || !symbol_table->getFuncsByName(arg_info->arg_name.c_str()).empty() || func_name == arg_info->arg_name || checkFormalRedef(arg_names, arg_info->arg_name)){
-                output::errorDef(arg_info->arg_line, arg_info->arg_name);
-                exit(0);
+            if(symbol_table->getVarSymbol(arg_info->arg_name) || !symbol_table->getFuncsByName(arg_info->arg_name).empty() || func_name == arg_info->arg_name || checkFormalRedef(arg_names, arg_info->arg_name)){
+                output::errorDef(arg_info->arg_line, nameStr(arg_info->arg_name));
+                abortCompilation();
             }
             arg_types.push_back(arg_info->arg_type);
             arg_names.push_back(arg_info->arg_name);
@@ -221,11 +226,11 @@ int addFunc(SymTable* symbol_table, const char* func_name, Type ret_type, vector
     // case of one other func that wasn't declared with override
     if(matches.size() == 1 && !matches[0]->is_override){
         if(is_override){
-            output::errorFuncNoOverride(yylineno, string(func_name));
-            exit(0);
+            output::errorFuncNoOverride(lineno(), nameStr(func_name));
+            abortCompilation();
         } else{ // both funcs declared without override
-            output::errorDef(yylineno, string(func_name));
-            exit(0);
+            output::errorDef(lineno(), nameStr(func_name));
+            abortCompilation();
         }
     }
 
@@ -237,28 +242,28 @@ int addFunc(SymTable* symbol_table, const char* func_name, Type ret_type, vector
      * - 0 other func with the same name => if is skipped
      * */
     if(!matches.empty() && !is_override){
-        output::errorOverrideWithoutDeclaration(yylineno, string(func_name));
-        exit(0);
+        output::errorOverrideWithoutDeclaration(lineno(), nameStr(func_name));
+        abortCompilation();
     }
 
     // check for another func with the exact same prototype
     for(auto& match: matches){
         if(match->type == ret_type && match->arg_types == arg_types){
-            output::errorDef(yylineno, string(func_name));
-            exit(0);
+            output::errorDef(lineno(), nameStr(func_name));
+            abortCompilation();
         }
     }
     symbol_table->addFuncSymbol(func_name, ret_type, arg_types, is_override, int(matches.size()));
     return int(matches.size());
 }
 
-void addFuncScope(SymTable* symbol_table, vector<ArgInfo*>* arg_list){
+void addFuncScope(SymTable* symbol_table, ArgList* arg_list){
     symbol_table->addNewScope();
     int offset = -1;
 
     if(arg_list){
         for(auto& arg_info: *arg_list){
-            symbol_table->addArgSymbol(arg_info->arg_name.c_str(), arg_info->arg_type, offset);
+            symbol_table->addArgSymbol(arg_info->arg_name, arg_info->arg_type, offset);
             offset--;
         }
     }
@@ -272,410 +277,477 @@ void delTopScope(SymTable* symbol_table){
     symbol_table->deleteTopScope();
 }
 
-string freshVar(){
-    static int idx = 0;
-    idx += 1;
-    return "%t" + to_string(idx);
+const string& nameStr(NameId name){
+    return NamePool::instance().str(name);
 }
 
-string freshGlobalStrVar(){
-    static int idx = 0;
-    idx += 1;
-    return "@s" + to_string(idx);
+IRType getIRType(Type type){
+    if(type == VOID_TYPE){
+        return IR_VOID;
+    } else if(type == STRING_TYPE){
+        return IR_I8_PTR;
+    } else if(type == BOOL_TYPE){
+        return IR_I1;
+    } else if(type == BYTE_TYPE){
+        return IR_I8;
+    }
+    return IR_I32;
 }
 
-void assignPlace(ExpInfo* exp_info){
-    exp_info->place.assign(freshVar());
+Operand toInt(Operand val){
+    if(val.type == IR_I32){
+        return val;
+    }
+    if(val.kind == OPND_CONST){
+        return Operand::constant(val.id & 0xff, IR_I32);
+    }
+    return CodeBuffer::instance().emitCast(OP_ZEXT, IR_I32, val);
 }
 
-void addDivByZeroCheck(ExpInfo* op2){
-    string is_zero = freshVar();
-    if(op2->type == BYTE_TYPE){
-        CodeBuffer::instance().emit(is_zero + " = icmp eq i8 0, " + op2->place);
-    } else { // int type
-        CodeBuffer::instance().emit(is_zero + " = icmp eq i32 0, " + op2->place);
+void setConstPlace(ExpInfo* target, int val){
+    target->is_const = true;
+    target->const_val = target->type == BYTE_TYPE ? (val & 0xff) : target->type == BOOL_TYPE ? val != 0 : val;
+    target->place = Operand::constant(target->const_val, getIRType(target->type));
+}
+
+bool foldBinary(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, Opcode op){
+    if(!op1->is_const || !op2->is_const){
+        return false;
     }
-    int addr = CodeBuffer::instance().emit("br i1 " + is_zero + ", label @, label @");
 
-    string exit_label = CodeBuffer::instance().genLabel();
-    CodeBuffer::instance().emit("call void @divByZero()");
-    CodeBuffer::instance().emit("unreachable");
+    // same wraparound as the emitted i32/i8 arithmetic, setConstPlace truncates bytes
+    uint32_t lhs = uint32_t(op1->const_val), rhs = uint32_t(op2->const_val);
+    uint32_t res;
+    if(op == OP_ADD){
+        res = lhs + rhs;
+    } else if(op == OP_SUB){
+        res = lhs - rhs;
+    } else if(op == OP_MUL){
+        res = lhs * rhs;
+    } else if(op == OP_UDIV){
+        res = lhs / rhs;
+    } else { // OP_SDIV, INT_MIN / -1 overflows and is left to run time
+        if(op1->const_val == INT32_MIN && op2->const_val == -1){
+            return false;
+        }
+        res = uint32_t(op1->const_val / op2->const_val);
+    }
+    setConstPlace(target, int32_t(res));
+    return true;
+}
+
+bool addDivByZeroCheck(ExpInfo* op2){
+    // a nonzero constant divisor needs no check
+    if(op2->is_const && op2->const_val != 0){
+        return false;
+    }
+
+    Operand is_zero = CodeBuffer::instance().emitICmp(ICMP_EQ, Operand::constant(0, op2->place.type), op2->place);
+    int addr = CodeBuffer::instance().emitCondBr(is_zero);
+
+    int exit_label = CodeBuffer::instance().genLabel();
+    CodeBuffer::instance().emitCall(IR_VOID, NamePool::instance().intern("divByZero"), {});
+    CodeBuffer::instance().emit(Instr(OP_UNREACHABLE, IR_VOID));
     CodeBuffer::instance().bpatch(CodeBuffer::makelist({addr,FIRST}),exit_label);
 
-    string continue_label = CodeBuffer::instance().genLabel();
+    int continue_label = CodeBuffer::instance().genLabel();
     CodeBuffer::instance().bpatch(CodeBuffer::makelist({addr,SECOND}),continue_label);
+    return true;
 }
 
-void emitBinary(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, string op){
-    if(op == "div"){
-        addDivByZeroCheck(op2);
+void emitBinary(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, Opcode op){
+    target->has_side_effects = op1->has_side_effects || op2->has_side_effects;
+    if(op == OP_SDIV){
         if(op1->type == BYTE_TYPE && op2->type == BYTE_TYPE){
-            op = "udiv";
-        } else {
-            op = "sdiv";
+            op = OP_UDIV;
+        }
+        // division by a constant zero is still an error at run time
+        if(op2->is_const && op2->const_val != 0 && foldBinary(target, op1, op2, op)){
+            return;
         }
+        // a checked division can exit, even if elideDivChecks drops the check later
+        target->has_side_effects |= addDivByZeroCheck(op2);
+    } else if(foldBinary(target, op1, op2, op)){
+        return;
     }
 
-    if(op1->type == INT_TYPE && op2->type == INT_TYPE){
-        CodeBuffer::instance().emit(target->place + " = " + op + " i32 " + op1->place + ", " + op2->place);
-    } else if(op1->type == INT_TYPE && op2->type == BYTE_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i8 " + op2->place + " to i32");
-        CodeBuffer::instance().emit(target->place + " = " + op + " i32 " + op1->place + ", " + temp);
-    } else if(op1->type == BYTE_TYPE && op2->type == INT_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i8 " + op1->place + " to i32");
-        CodeBuffer::instance().emit(target->place + " = " + op + " i32 " + temp + ", " + op2->place);
-    } else { // both byte
-        CodeBuffer::instance().emit(target->place + " = " + op + " i8 " + op1->place + ", " + op2->place);
+    if(op1->type == BYTE_TYPE && op2->type == BYTE_TYPE){
+        target->place = CodeBuffer::instance().emitBinop(op, IR_I8, op1->place, op2->place);
+    } else {
+        target->place = CodeBuffer::instance().emitBinop(op, IR_I32, toInt(op1->place), toInt(op2->place));
     }
 }
 
-void emitLoadCommand(ExpInfo* target, SymTable* symbol_table, const char* id_name, string& base_ptr){
-    SymTableEntry* symbol = symbol_table->getVarSymbol(id_name);
-    if(symbol->offset < 0){ // func arg
-        if(symbol->type == BOOL_TYPE){
-            CodeBuffer::instance().emit(target->place + " = add i1 0, " + "%arg" + to_string(abs(symbol->offset)));
-        } else if(symbol->type == BYTE_TYPE){
-            CodeBuffer::instance().emit(target->place + " = add i8 0, " + "%arg" + to_string(abs(symbol->offset)));
-        } else {
-            CodeBuffer::instance().emit(target->place + " = add i32 0, " + "%arg" + to_string(abs(symbol->offset)));
-        }
-    } else { // local variable
-        string element_ptr = freshVar();
-        CodeBuffer::instance().emit(element_ptr + " = getelementptr i32, i32* " + base_ptr + ", i32 " + to_string(symbol->offset));
-        if(symbol->type == BOOL_TYPE){
-            string temp = freshVar();
-            CodeBuffer::instance().emit(temp + " = load i32, i32* " + element_ptr);
-            CodeBuffer::instance().emit(target->place + " = trunc i32 " + temp + " to i1");
-        } else if(symbol->type == BYTE_TYPE){
-            string temp = freshVar();
-            CodeBuffer::instance().emit(temp + " = load i32, i32* " + element_ptr);
-            CodeBuffer::instance().emit(target->place + " = trunc i32 " + temp + " to i8");
+void emitJumpOnBool(ExpInfo* target){
+    if(target->jumping){
+        return;
+    }
+    target->jumping = true;
+    if(target->is_const){
+        int addr = CodeBuffer::instance().emitBr();
+        if(target->const_val){
+            target->truelist = CodeBuffer::makelist({addr,FIRST});
         } else {
-            CodeBuffer::instance().emit(target->place + " = load i32, i32* " + element_ptr);
+            target->falselist = CodeBuffer::makelist({addr,FIRST});
         }
+        return;
     }
 
-    if(symbol->type == BOOL_TYPE){
-        string cond = freshVar();
-        CodeBuffer::instance().emit(cond + " = icmp eq i1 1, " + target->place);
-        int addr = CodeBuffer::instance().emit("br i1 " + cond + ", label @, label @");
-        target->truelist = CodeBuffer::makelist({addr,FIRST});
-        target->falselist = CodeBuffer::makelist({addr,SECOND});
-    }
+    int addr = CodeBuffer::instance().emitCondBr(target->place);
+    target->truelist = CodeBuffer::makelist({addr,FIRST});
+    target->falselist = CodeBuffer::makelist({addr,SECOND});
 }
 
-void emitNumToPlace(string& place, int val, Type type){
-    if(type == BYTE_TYPE){
-        CodeBuffer::instance().emit(place + " = add i8 0, " + to_string(val));
-    } else {
-        CodeBuffer::instance().emit(place + " = add i32 0, " + to_string(val));
+void condAction(ExpInfo* cond){
+    // a condition that isn't a bool is reported by M
+    if(cond->type == BOOL_TYPE){
+        emitJumpOnBool(cond);
     }
 }
 
-void emitStrToGlobal(ExpInfo* target, const char* str){
-    string str_var = freshGlobalStrVar();
-    string str_type = "[" + to_string(strlen(str)-1) + " x i8]";
-    string real_str = string(str);
-    real_str.pop_back();
+void emitLoadCommand(ExpInfo* target, SymTable* symbol_table, NameId id_name){
+    SymTableEntry* symbol = symbol_table->getVarSymbol(id_name);
+    target->place = CodeBuffer::instance().emitLoad(getIRType(symbol->type), symbol->slot);
+}
+
+void emitNumToPlace(ExpInfo* target, int val){
+    setConstPlace(target, val);
+}
 
-    CodeBuffer::instance().emitGlobal(str_var + " = internal constant " + str_type + " c" + real_str + "\\00\"");
-    CodeBuffer::instance().emit(target->place + " = getelementptr " + str_type + ", " + str_type + "* " + str_var + ", i32 0, i32 0");
+void emitStrToGlobal(ExpInfo* target, NameId str){
+    int str_idx = CodeBuffer::instance().emitString(nameStr(str));
+    target->place = CodeBuffer::instance().emitStrPtr(str_idx);
 }
 
-char* copyLabelStr(){
+int copyLabelStr(){
     /* might need to add br before new label in order to meet LLVM
      * basic block condition that it always ends with br or ret */
-    int addr = CodeBuffer::instance().emit("br label @");
-    string label = CodeBuffer::instance().genLabel();
+    int addr = CodeBuffer::instance().emitBr();
+    int label = CodeBuffer::instance().genLabel();
     CodeBuffer::instance().bpatch(CodeBuffer::makelist({addr,FIRST}),label);
-    char* copy = strdup(label.c_str());
-    return copy;
+    return label;
 }
 
 void notAction(ExpInfo* target, ExpInfo* op){
-    target->truelist = move(op->falselist);
-    target->falselist = move(op->truelist);
+    target->has_side_effects = op->has_side_effects;
+    if(op->jumping){
+        target->jumping = true;
+        target->truelist = move(op->falselist);
+        target->falselist = move(op->truelist);
+    } else if(op->is_const){
+        setConstPlace(target, !op->const_val);
+    } else {
+        target->place = CodeBuffer::instance().emitBinop(OP_XOR, IR_I1, op->place, Operand::constant(1, IR_I1));
+    }
+}
+
+/* and (is_and) or or of op1 and op2, where op2's code starts at label, after the br that ends op1's code.
+ * op1's value decides the result without op2 when it is false for and, true for or. two values are combined
+ * with an i1 and/or when op2 can be evaluated unconditionally. otherwise the short circuit is kept: the br
+ * ending op1 becomes a branch on it, and the result is jumping code */
+static void logicAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, int label, bool is_and){
+    target->has_side_effects = op1->has_side_effects || op2->has_side_effects;
+    int decides = is_and ? 0 : 1;
+    int op1_end = label - 1;
+
+    if(op1->is_const){
+        if(op1->const_val == decides){
+            // op2's code is jumped over, its branches lead nowhere else
+            int next = CodeBuffer::instance().genLabel();
+            CodeBuffer::instance().bpatch(op2->truelist,next);
+            CodeBuffer::instance().bpatch(op2->falselist,next);
+            CodeBuffer::instance().bpatch(CodeBuffer::makelist({op1_end,FIRST}),next);
+            setConstPlace(target, decides);
+        } else {
+            target->place = op2->place;
+            target->jumping = op2->jumping;
+            target->truelist = move(op2->truelist);
+            target->falselist = move(op2->falselist);
+            target->is_const = op2->is_const;
+            target->const_val = op2->const_val;
+        }
+        return;
+    }
+
+    if(!op1->jumping && !op2->jumping && !op2->has_side_effects){
+        if(op2->is_const && op2->const_val == decides){
+            setConstPlace(target, decides); // op1 is still evaluated, its code is already emitted
+        } else if(op2->is_const){
+            target->place = op1->place;
+        } else {
+            target->place = CodeBuffer::instance().emitBinop(is_and ? OP_AND : OP_OR, IR_I1, op1->place, op2->place);
+        }
+        return;
+    }
+
+    PatchList op1_decided;
+    if(op1->jumping){
+        CodeBuffer::instance().bpatch(is_and ? op1->truelist : op1->falselist,label);
+        op1_decided = move(is_and ? op1->falselist : op1->truelist);
+    } else {
+        CodeBuffer::instance().convertToCondBr(op1_end, op1->place, is_and ? FIRST : SECOND);
+        op1_decided = CodeBuffer::makelist({op1_end, is_and ? SECOND : FIRST});
+    }
+    emitJumpOnBool(op2);
+    target->jumping = true;
+    if(is_and){
+        target->truelist = move(op2->truelist);
+        target->falselist = CodeBuffer::merge(op1_decided,op2->falselist);
+    } else {
+        target->truelist = CodeBuffer::merge(op1_decided,op2->truelist);
+        target->falselist = move(op2->falselist);
+    }
 }
 
-void andAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, const char* label){
-    CodeBuffer::instance().bpatch(op1->truelist,string(label));
-    target->truelist = move(op2->truelist);
-    target->falselist = CodeBuffer::merge(op1->falselist,op2->falselist);
+void andAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, int label){
+    logicAction(target, op1, op2, label, true);
 }
 
-void orAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, const char* label){
-    CodeBuffer::instance().bpatch(op1->falselist,string(label));
-    target->truelist = CodeBuffer::merge(op1->truelist,op2->truelist);
-    target->falselist = move(op2->falselist);
+void orAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, int label){
+    logicAction(target, op1, op2, label, false);
 }
 
-void relopAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, string op){
-    string cond = freshVar();
-    if(op1->type == INT_TYPE && op2->type == INT_TYPE){
-        CodeBuffer::instance().emit(cond + " = icmp " + op + " i32 " + op1->place + ", " + op2->place);
-    } else if(op1->type == INT_TYPE && op2->type == BYTE_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i8 " + op2->place + " to i32");
-        CodeBuffer::instance().emit(cond + " = icmp " + op + " i32 " + op1->place + ", " + temp);
-    } else if(op1->type == BYTE_TYPE && op2->type == INT_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i8 " + op1->place + " to i32");
-        CodeBuffer::instance().emit(cond + " = icmp " + op + " i32 " + temp + ", " + op2->place);
-    } else { // both byte
-        CodeBuffer::instance().emit(cond + " = icmp " + op + " i8 " + op1->place + ", " + op2->place);
+bool foldRelop(ExpInfo* op1, ExpInfo* op2, ICmpPred pred, bool& res){
+    if(!op1->is_const || !op2->is_const){
+        return false;
     }
 
-    int addr = CodeBuffer::instance().emit("br i1 " + cond + ", label @, label @");
-    target->truelist = CodeBuffer::makelist({addr,FIRST});
-    target->falselist = CodeBuffer::makelist({addr,SECOND});
+    // byte comparisons are emitted as signed i8 predicates, fold them the same way
+    int lhs = op1->const_val, rhs = op2->const_val;
+    if(op1->type == BYTE_TYPE && op2->type == BYTE_TYPE){
+        lhs = int8_t(lhs);
+        rhs = int8_t(rhs);
+    }
+
+    switch(pred){
+        case ICMP_EQ: res = lhs == rhs; break;
+        case ICMP_NE: res = lhs != rhs; break;
+        case ICMP_SLT: res = lhs < rhs; break;
+        case ICMP_SLE: res = lhs <= rhs; break;
+        case ICMP_SGT: res = lhs > rhs; break;
+        case ICMP_SGE: res = lhs >= rhs; break;
+    }
+    return true;
 }
 
-void boolAction(ExpInfo* target, bool val){
-    int addr = CodeBuffer::instance().emit("br label @");
-    if(val){
-        target->truelist = CodeBuffer::makelist({addr,FIRST});
-        target->falselist.clear();
+void relopAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, ICmpPred pred){
+    target->has_side_effects = op1->has_side_effects || op2->has_side_effects;
+    bool res;
+    if(foldRelop(op1, op2, pred, res)){
+        boolAction(target, res);
+        return;
+    }
+
+    if(op1->type == BYTE_TYPE && op2->type == BYTE_TYPE){
+        target->place = CodeBuffer::instance().emitICmp(pred, op1->place, op2->place);
     } else {
-        target->falselist = CodeBuffer::makelist({addr,FIRST});
-        target->truelist.clear();
+        target->place = CodeBuffer::instance().emitICmp(pred, toInt(op1->place), toInt(op2->place));
     }
 }
 
+void boolAction(ExpInfo* target, bool val){
+    setConstPlace(target, val);
+}
+
 void conversionAction(ExpInfo* target, ExpInfo* op, Type target_type){
-    if(target_type == BYTE_TYPE && op->type ==INT_TYPE){
-        CodeBuffer::instance().emit(target->place + " = trunc i32 " + op->place + " to i8");
-    } else if(target_type == INT_TYPE && op->type == INT_TYPE){
-        CodeBuffer::instance().emit(target->place + " = add i32 0, " + op->place);
+    target->has_side_effects = op->has_side_effects;
+    if(op->is_const){
+        setConstPlace(target, op->const_val);
+        return;
+    }
+
+    Operand val = op->place;
+    if(target_type == BYTE_TYPE && op->type == INT_TYPE){
+        target->place = CodeBuffer::instance().emitCast(OP_TRUNC, IR_I8, val);
     } else if(target_type == INT_TYPE && op->type == BYTE_TYPE){
-        CodeBuffer::instance().emit(target->place + " = zext i8 " + op->place + " to i32");
-    } else { // both byte
-        CodeBuffer::instance().emit(target->place + " = add i8 0, " + op->place);
+        target->place = CodeBuffer::instance().emitCast(OP_ZEXT, IR_I32, val);
+    } else { // same type
+        target->place = CodeBuffer::instance().emitBinop(OP_ADD, val.type, Operand::constant(0, val.type), val);
     }
 }
 
-string getLLVMTypeStr(Type type){
-    if(type == VOID_TYPE){
-        return "void";
+NameId getFuncIRName(NameId func_name, bool is_main, int func_idx){
+    if(is_main){
+        return func_name;
     }
-    else if(type == STRING_TYPE){
-        return "i8*";
-    } else if(type == BOOL_TYPE){
-        return "i1";
-    } else if(type == BYTE_TYPE){
-        return "i8";
-    }
-    return "i32";
+    return NamePool::instance().intern(nameStr(func_name) + to_string(func_idx));
 }
 
-string createFunc(const char* func_name, Type ret_type, vector<ArgInfo*>* arg_list, int func_idx){
-    string real_func_name;
+void createFunc(SymTable* symbol_table, NameId func_name, Type ret_type, ArgList* arg_list, int func_idx){
+    bool is_main = nameStr(func_name) == "main" && ret_type == VOID_TYPE && !arg_list;
 
-    if(string(func_name) == "main" && ret_type == VOID_TYPE && !arg_list){
-        real_func_name = "@" + string(func_name);
-    } else {
-        real_func_name = "@" + string(func_name) + to_string(func_idx);
+    vector<IRType> arg_types;
+    if(arg_list){
+        for(auto& arg_info: *arg_list){
+            arg_types.push_back(getIRType(arg_info->arg_type));
+        }
     }
 
-    string ret_type_str = getLLVMTypeStr(ret_type);
+    CodeBuffer::instance().openFunc(getFuncIRName(func_name, is_main, func_idx), getIRType(ret_type), arg_types);
 
-    string args_str;
-    int arg_idx = 1;
+    // arguments are assignable, so they live in slots like the local variables
     if(arg_list){
         for(auto& arg_info: *arg_list){
-            args_str += getLLVMTypeStr(arg_info->arg_type) + " %arg" + to_string(arg_idx) + ", ";
-            arg_idx++;
+            SymTableEntry* symbol = symbol_table->getVarSymbol(arg_info->arg_name);
+            IRType type = getIRType(symbol->type);
+            symbol->slot = CodeBuffer::instance().emitAlloca(type);
+            CodeBuffer::instance().emitStore(Operand::arg(-symbol->offset, type), symbol->slot);
         }
-        args_str.pop_back();
-        args_str.pop_back();
     }
-
-    CodeBuffer::instance().emit("define " + ret_type_str + " " + real_func_name + "(" + args_str + ") {");
-    string base_ptr = freshVar();
-    CodeBuffer::instance().emit(base_ptr + " = alloca i32, i32 50");
-    return base_ptr;
 }
 
-string getDefaultVal(Type ret_type){
+Operand getDefaultVal(Type ret_type){
     if(ret_type == VOID_TYPE){
-        return "";
+        return Operand();
     }
-    return "0";
+    return Operand::constant(0, getIRType(ret_type));
 }
 
 void closeFunc(Type ret_type, StatementInfo* st_info){
-    int addr = CodeBuffer::instance().emit("br label @");
-    string end_label = CodeBuffer::instance().genLabel();
+    int addr = CodeBuffer::instance().emitBr();
+    int end_label = CodeBuffer::instance().genLabel();
     CodeBuffer::instance().bpatch(CodeBuffer::makelist({addr,FIRST}),end_label);
 
-    CodeBuffer::instance().emit("ret " + getLLVMTypeStr(ret_type) + " " + getDefaultVal(ret_type));
-    CodeBuffer::instance().emit("}");
+    CodeBuffer::instance().emitRet(getDefaultVal(ret_type));
     CodeBuffer::instance().bpatch(st_info->nextlist,end_label);
+    CodeBuffer::instance().closeFunc();
+
+    // the function's semantic values are not referenced after this point
+    Arena::instance().release();
 }
 
-void emitVarDec(SymTable* symbol_table, const char* name, Type type, ExpInfo* exp_info, string& base_ptr){
-    string val;
-    if(!exp_info){
-        val = getDefaultVal(type);
-    } else {
-        val = exp_info->place;
+void emitStoreToVar(SymTableEntry* symbol, Operand val){
+    // a byte is the only value assignable to a variable of another type
+    if(symbol->type == INT_TYPE){
+        val = toInt(val);
     }
+    CodeBuffer::instance().emitStore(val, symbol->slot);
+}
 
+void emitVarDec(SymTable* symbol_table, NameId name, Type type, ExpInfo* exp_info){
     SymTableEntry* symbol = symbol_table->getVarSymbol(name);
-    string element_ptr = freshVar();
-    CodeBuffer::instance().emit(element_ptr + " = getelementptr i32, i32* " + base_ptr + ", i32 " + to_string(symbol->offset));
+    IRType ir_type = getIRType(type);
+    symbol->slot = CodeBuffer::instance().emitAlloca(ir_type);
 
-    if(exp_info && exp_info->type == BOOL_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i1 " + val + " to i32");
-        val = temp;
-    }
-    if(exp_info && exp_info->type == BYTE_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i8 " + val + " to i32");
-        val = temp;
+    Operand val;
+    if(!exp_info){
+        val = Operand::constant(0, ir_type);
+    } else {
+        val = exp_info->place;
     }
 
-    CodeBuffer::instance().emit("store i32 " + val + ", i32* " + element_ptr);
+    emitStoreToVar(symbol, val);
 }
 
-void emitVarReassign(SymTable* symbol_table, const char* name, ExpInfo* exp_info, string& base_ptr){
-    SymTableEntry* symbol = symbol_table->getVarSymbol(name);
-    string element_ptr = freshVar();
-    CodeBuffer::instance().emit(element_ptr + " = getelementptr i32, i32* " + base_ptr + ", i32 " + to_string(symbol->offset));
-
-    string val = exp_info->place;
-
-    if(exp_info->type == BOOL_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i1 " + val + " to i32");
-        val = temp;
-    }
-    if(exp_info->type == BYTE_TYPE){
-        string temp = freshVar();
-        CodeBuffer::instance().emit(temp + " = zext i8 " + val + " to i32");
-        val = temp;
-    }
-
-    CodeBuffer::instance().emit("store i32 " + val + ", i32* " + element_ptr);
+void emitVarReassign(SymTable* symbol_table, NameId name, ExpInfo* exp_info){
+    emitStoreToVar(symbol_table->getVarSymbol(name), exp_info->place);
 }
 
 void emitRet(ExpInfo* exp_info, Type ret_type){
     if(!exp_info){
-        CodeBuffer::instance().emit("ret void");
+        CodeBuffer::instance().emitRet();
+    } else if(exp_info->type == BYTE_TYPE && ret_type == INT_TYPE){
+        CodeBuffer::instance().emitRet(toInt(exp_info->place));
     } else {
-        if(exp_info->type == BYTE_TYPE && ret_type == INT_TYPE){
-            string temp = freshVar();
-            CodeBuffer::instance().emit(temp + " = zext i8 " + exp_info->place + " to i32");
-            CodeBuffer::instance().emit("ret " + getLLVMTypeStr(ret_type) + " " + temp);
-        } else {
-            CodeBuffer::instance().emit("ret " + getLLVMTypeStr(ret_type) + " " + exp_info->place);
-        }
+        CodeBuffer::instance().emitRet(exp_info->place);
     }
 }
 
-void ifAction(StatementInfo* target, ExpInfo* exp_info, const char* label, StatementInfo* st_info){
-    CodeBuffer::instance().bpatch(exp_info->truelist,string(label));
+void ifAction(StatementInfo* target, ExpInfo* exp_info, int label, StatementInfo* st_info){
+    // the body of if(false) is never entered, and nothing after it jumps back in.
+    // a truelist left by dead code (false && x) still needs a target, those bodies are kept
+    if(exp_info->is_const && !exp_info->const_val && exp_info->truelist.empty()){
+        CodeBuffer::instance().discardBlocks(label);
+        target->nextlist = move(exp_info->falselist);
+        return;
+    }
+
+    CodeBuffer::instance().bpatch(exp_info->truelist,label);
     target->nextlist = CodeBuffer::merge(exp_info->falselist,st_info->nextlist);
     target->breaklist = move(st_info->breaklist);
     target->continuelist = move(st_info->continuelist);
 }
 
 void N_Action(StatementInfo* target){
-    int addr = CodeBuffer::instance().emit("br label @");
+    int addr = CodeBuffer::instance().emitBr();
     target->nextlist = CodeBuffer::makelist({addr,FIRST});
 }
 
-void ifElseAction(StatementInfo* target, ExpInfo* if_exp, const char* true_label, StatementInfo* if_st, StatementInfo* N_st, char* false_label, StatementInfo* else_st){
-    CodeBuffer::instance().bpatch(if_exp->truelist,string(true_label));
-    CodeBuffer::instance().bpatch(if_exp->falselist,string(false_label));
-    target->nextlist = CodeBuffer::merge(CodeBuffer::merge(if_st->nextlist,N_st->nextlist),else_st->nextlist);
+void ifElseAction(StatementInfo* target, ExpInfo* if_exp, int true_label, StatementInfo* if_st, StatementInfo* N_st, int false_label, StatementInfo* else_st){
+    CodeBuffer::instance().bpatch(if_exp->truelist,true_label);
+    CodeBuffer::instance().bpatch(if_exp->falselist,false_label);
+    PatchList if_nextlist = CodeBuffer::merge(if_st->nextlist,N_st->nextlist);
+    target->nextlist = CodeBuffer::merge(if_nextlist,else_st->nextlist);
     target->breaklist = CodeBuffer::merge(if_st->breaklist,else_st->breaklist);
     target->continuelist = CodeBuffer::merge(if_st->continuelist,else_st->continuelist);
 }
 
-void whileAction(StatementInfo* target, const char* cond_label, ExpInfo* while_exp, const char* body_label, StatementInfo* while_st){
-    CodeBuffer::instance().bpatch(while_st->nextlist,string(cond_label));
-    CodeBuffer::instance().bpatch(while_st->continuelist,string(cond_label));
-    CodeBuffer::instance().bpatch(while_exp->truelist,string(body_label));
+void whileAction(StatementInfo* target, int cond_label, ExpInfo* while_exp, int body_label, StatementInfo* while_st){
+    if(while_exp->is_const && !while_exp->const_val && while_exp->truelist.empty()){
+        CodeBuffer::instance().discardBlocks(body_label);
+        target->nextlist = move(while_exp->falselist);
+        return;
+    }
+
+    CodeBuffer::instance().bpatch(while_st->nextlist,cond_label);
+    CodeBuffer::instance().bpatch(while_st->continuelist,cond_label);
+    CodeBuffer::instance().bpatch(while_exp->truelist,body_label);
 
     target->nextlist = CodeBuffer::merge(while_exp->falselist,while_st->breaklist);
-    CodeBuffer::instance().emit("br label %" + string(cond_label));
+    CodeBuffer::instance().emitBr(cond_label);
 }
 
-void statementAction(StatementInfo* target, StatementInfo* st_info, const char* label){
-    CodeBuffer::instance().bpatch(st_info->nextlist,string(label));
+void statementAction(StatementInfo* target, StatementInfo* st_info, int label){
+    CodeBuffer::instance().bpatch(st_info->nextlist,label);
     target->breaklist = CodeBuffer::merge(target->breaklist,st_info->breaklist);
     target->continuelist = CodeBuffer::merge(target->continuelist,st_info->continuelist);
 }
 
 void breakAction(StatementInfo* st_info){
-    int addr = CodeBuffer::instance().emit("br label @");
+    int addr = CodeBuffer::instance().emitBr();
     st_info->breaklist = CodeBuffer::makelist({addr,FIRST});
 }
 
 void continueAction(StatementInfo* st_info){
-    int addr = CodeBuffer::instance().emit("br label @");
+    int addr = CodeBuffer::instance().emitBr();
     st_info->continuelist = CodeBuffer::makelist({addr,FIRST});
 }
 
-void callAction(SymTable* symbol_table, ExpInfo* target, const char* func_name, vector<ExpInfo*>* args){
+void callAction(SymTable* symbol_table, ExpInfo* target, NameId func_name, ExpList* args){
     SymTableEntry* match = checkIfLegalCall(symbol_table,func_name,args);
     target->type = match->type;
 
-    string real_func_name;
-    if(string(func_name) == "main" && !args){
-        real_func_name = "@" + string(func_name);
-    } else {
-        real_func_name = "@" + string(func_name) + to_string(match->func_idx);
-    }
+    bool is_main = nameStr(func_name) == "main" && !args;
 
-    string args_str;
+    vector<Operand> ir_args;
     if(args){
         for(unsigned long i = 0; i < args->size(); i++){
             if(match->arg_types[i] == args->at(i)->type){
-                args_str += getLLVMTypeStr(args->at(i)->type) + " " + args->at(i)->place + ", ";
+                ir_args.push_back(args->at(i)->place);
             } else {
-                string temp = freshVar();
-                CodeBuffer::instance().emit(temp + " = zext i8 " + args->at(i)->place + " to i32");
-                args_str += getLLVMTypeStr(match->arg_types[i]) + " " + temp + ", ";
+                ir_args.push_back(toInt(args->at(i)->place));
             }
         }
-        args_str.pop_back();
-        args_str.pop_back();
-    }
-    if(target->type != VOID_TYPE) {
-        CodeBuffer::instance().emit(target->place + " = call " + getLLVMTypeStr(match->type) + " " + real_func_name + "(" + args_str + ")");
-    } else {
-        CodeBuffer::instance().emit("call " + getLLVMTypeStr(match->type) + " " + real_func_name + "(" + args_str + ")");
-    }
-}
-
-void expCallAction(ExpInfo* target){
-    if(target->type == BOOL_TYPE){
-        string cond = freshVar();
-        CodeBuffer::instance().emit(cond + " = icmp eq i1 1, " + target->place);
-        int addr = CodeBuffer::instance().emit("br i1 " + cond + ", label @, label @");
-        target->truelist = CodeBuffer::makelist({addr,FIRST});
-        target->falselist = CodeBuffer::makelist({addr,SECOND});
     }
+    target->place = CodeBuffer::instance().emitCall(getIRType(match->type), getFuncIRName(func_name, is_main, match->func_idx), ir_args);
+    target->has_side_effects = true;
 }
 
 void evalBoolExp(ExpInfo* exp_info){
-    if(exp_info->type != BOOL_TYPE){
+    if(exp_info->type != BOOL_TYPE || !exp_info->jumping){
         return;
     }
-    exp_info->place.assign(freshVar());
+    exp_info->jumping = false;
 
-    string true_label = CodeBuffer::instance().genLabel();
-    int addr1 = CodeBuffer::instance().emit("br label @");
+    int true_label = CodeBuffer::instance().genLabel();
+    int addr1 = CodeBuffer::instance().emitBr();
 
-    string false_label = CodeBuffer::instance().genLabel();
-    int addr2 = CodeBuffer::instance().emit("br label @");
+    int false_label = CodeBuffer::instance().genLabel();
+    int addr2 = CodeBuffer::instance().emitBr();
 
-    string assign_label = CodeBuffer::instance().genLabel();
-    CodeBuffer::instance().emit(exp_info->place + " = phi i1 [1, %" + true_label + "], [0, %" + false_label + "]");
+    int assign_label = CodeBuffer::instance().genLabel();
+    exp_info->place = CodeBuffer::instance().emitPhi(IR_I1, {{Operand::constant(1, IR_I1), true_label},
+                                                             {Operand::constant(0, IR_I1), false_label}});
 
     CodeBuffer::instance().bpatch(exp_info->truelist,true_label);
     CodeBuffer::instance().bpatch(exp_info->falselist,false_label);
@@ -684,28 +756,121 @@ void evalBoolExp(ExpInfo* exp_info){
     CodeBuffer::instance().bpatch(CodeBuffer::makelist({addr2,FIRST}),assign_label);
 }
 
-void initCodeBuff(){
-    vector<string> print_func = {"declare i32 @printf(i8*, ...)\n",
+void initCodeBuff(bool host_runtime){
+    if(host_runtime){
+        // the runtime functions are provided by the process running the module
+        CodeBuffer::instance().emitGlobal("declare void @printi0(i32)");
+        CodeBuffer::instance().emitGlobal("declare void @print0(i8*)");
+        CodeBuffer::instance().emitGlobal("declare void @divByZero()\n");
+        return;
+    }
+
+    // print0 and printi0 append lines to a buffer (printi0 formats the number itself) that is written
+    // with write() when full, at exit by a global destructor and by divByZero before it exits
+    vector<string> print_func = {"declare i64 @write(i32, i8*, i64)\n",
+                                 "declare i64 @strlen(i8*)\n",
                                  "declare void @exit(i32)\n",
-                                 "@.int_specifier = constant [4 x i8] c\"%d\\0A\\00\"\n",
-                                 "@.str_specifier = constant [4 x i8] c\"%s\\0A\\00\"\n",
+                                 "declare void @llvm.memcpy.p0i8.p0i8.i64(i8*, i8*, i64, i1)\n",
+                                 "@.out_buf = internal global [65536 x i8] zeroinitializer\n",
+                                 "@.out_len = internal global i64 0\n",
+                                 "@llvm.global_dtors = appending global [1 x { i32, void ()*, i8* }] [{ i32, void ()*, i8* } { i32 65535, void ()* @.flush, i8* null }]\n",
                                  "@zero_error = constant [23 x i8] c\"Error division by zero\\00\"\n",
                                  "\n",
+                                 "define internal void @.write_all(i8* %str, i64 %len) {\n",
+                                 "entry:\n",
+                                 "    br label %check\n",
+                                 "check:\n",
+                                 "    %done = phi i64 [0, %entry], [%next, %write]\n",
+                                 "    %more = icmp slt i64 %done, %len\n",
+                                 "    br i1 %more, label %write, label %end\n",
+                                 "write:\n",
+                                 "    %ptr = getelementptr i8, i8* %str, i64 %done\n",
+                                 "    %left = sub i64 %len, %done\n",
+                                 "    %written = call i64 @write(i32 1, i8* %ptr, i64 %left)\n",
+                                 "    %next = add i64 %done, %written\n",
+                                 "    %failed = icmp sle i64 %written, 0\n",
+                                 "    br i1 %failed, label %end, label %check\n",
+                                 "end:\n",
+                                 "    ret void\n",
+                                 "}\n",
+                                 "\n",
+                                 "define internal void @.flush() {\n",
+                                 "    %buf = getelementptr [65536 x i8], [65536 x i8]* @.out_buf, i64 0, i64 0\n",
+                                 "    %len = load i64, i64* @.out_len\n",
+                                 "    store i64 0, i64* @.out_len\n",
+                                 "    call void @.write_all(i8* %buf, i64 %len)\n",
+                                 "    ret void\n",
+                                 "}\n",
+                                 "\n",
+                                 "define internal void @.print_line(i8* %str, i64 %len) {\n",
+                                 "entry:\n",
+                                 "    %used = load i64, i64* @.out_len\n",
+                                 "    %line = add i64 %len, 1\n",
+                                 "    %end = add i64 %used, %line\n",
+                                 "    %fits = icmp ule i64 %end, 65536\n",
+                                 "    br i1 %fits, label %copy, label %full\n",
+                                 "full:\n",
+                                 "    call void @.flush()\n",
+                                 "    %fits_empty = icmp ule i64 %line, 65536\n",
+                                 "    br i1 %fits_empty, label %copy, label %direct\n",
+                                 "direct:\n",
+                                 "    call void @.write_all(i8* %str, i64 %len)\n",
+                                 "    br label %copy_newline\n",
+                                 "copy:\n",
+                                 "    %at = phi i64 [%used, %entry], [0, %full]\n",
+                                 "    %dst = getelementptr [65536 x i8], [65536 x i8]* @.out_buf, i64 0, i64 %at\n",
+                                 "    call void @llvm.memcpy.p0i8.p0i8.i64(i8* %dst, i8* %str, i64 %len, i1 false)\n",
+                                 "    %text_end = add i64 %at, %len\n",
+                                 "    br label %copy_newline\n",
+                                 "copy_newline:\n",
+                                 "    %newline_at = phi i64 [0, %direct], [%text_end, %copy]\n",
+                                 "    %newline = getelementptr [65536 x i8], [65536 x i8]* @.out_buf, i64 0, i64 %newline_at\n",
+                                 "    store i8 10, i8* %newline\n",
+                                 "    %new_used = add i64 %newline_at, 1\n",
+                                 "    store i64 %new_used, i64* @.out_len\n",
+                                 "    ret void\n",
+                                 "}\n",
+                                 "\n",
                                  "define void @printi0(i32) {\n",
-                                 "    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.int_specifier, i32 0, i32 0\n",
-                                 "    call i32 (i8*, ...) @printf(i8* %spec_ptr, i32 %0)\n",
+                                 "entry:\n",
+                                 "    %digits = alloca [11 x i8]\n",
+                                 "    %neg = icmp slt i32 %0, 0\n",
+                                 "    %minus = sub i32 0, %0\n",
+                                 "    %abs = select i1 %neg, i32 %minus, i32 %0\n",
+                                 "    br label %digit\n",
+                                 "digit:\n",
+                                 "    %val = phi i32 [%abs, %entry], [%rest, %digit]\n",
+                                 "    %pos = phi i64 [11, %entry], [%prev, %digit]\n",
+                                 "    %rest = udiv i32 %val, 10\n",
+                                 "    %mod = urem i32 %val, 10\n",
+                                 "    %mod8 = trunc i32 %mod to i8\n",
+                                 "    %char = add i8 %mod8, 48\n",
+                                 "    %prev = sub i64 %pos, 1\n",
+                                 "    %char_ptr = getelementptr [11 x i8], [11 x i8]* %digits, i64 0, i64 %prev\n",
+                                 "    store i8 %char, i8* %char_ptr\n",
+                                 "    %again = icmp ne i32 %rest, 0\n",
+                                 "    br i1 %again, label %digit, label %sign\n",
+                                 "sign:\n",
+                                 "    %sign_pos = sub i64 %prev, 1\n",
+                                 "    %sign_ptr = getelementptr [11 x i8], [11 x i8]* %digits, i64 0, i64 %sign_pos\n",
+                                 "    store i8 45, i8* %sign_ptr\n",
+                                 "    %first = select i1 %neg, i64 %sign_pos, i64 %prev\n",
+                                 "    %start = getelementptr [11 x i8], [11 x i8]* %digits, i64 0, i64 %first\n",
+                                 "    %len = sub i64 11, %first\n",
+                                 "    call void @.print_line(i8* %start, i64 %len)\n",
                                  "    ret void\n",
                                  "}\n",
                                  "\n",
                                  "define void @print0(i8*) {\n",
-                                 "    %spec_ptr = getelementptr [4 x i8], [4 x i8]* @.str_specifier, i32 0, i32 0\n",
-                                 "    call i32 (i8*, ...) @printf(i8* %spec_ptr, i8* %0)\n",
+                                 "    %len = call i64 @strlen(i8* %0)\n",
+                                 "    call void @.print_line(i8* %0, i64 %len)\n",
                                  "    ret void\n",
                                  "}\n",
                                  "\n",
                                  "define void @divByZero() {\n",
                                  "    %zero_error_ptr = getelementptr [23 x i8], [23 x i8]* @zero_error, i32 0, i32 0\n",
                                  "    call void @print0(i8* %zero_error_ptr)\n",
+                                 "    call void @.flush()\n",
                                  "    call void @exit(i32 0)\n",
                                  "    ret void\n",
                                  "}"};
@@ -714,7 +879,6 @@ void initCodeBuff(){
     }
 }
 
-void printCodeBuff(){
-    CodeBuffer::instance().printGlobalBuffer();
-    CodeBuffer::instance().printCodeBuffer();
+void printCodeBuff(ostream& os){
+    CodeBuffer::instance().printAll(os);
 }
\ No newline at end of file
@@ -2,11 +2,13 @@
 #define HW3_BISON_CODE_H
 
 #include "SymTable.hpp"
+#include "Compiler.hpp"
 #include<string.h>
 
-extern int yylineno;
+//line the scanner of the current compilation is at, for diagnostics
+int lineno();
 
-void initSymTable(SymTable* symbol_table, vector<string>& predefined_func);
+void initSymTable(SymTable* symbol_table, vector<NameId>& predefined_func);
 void checkMain(SymTable* symbol_table);
 
 bool isNumeric(Type type);
@@ -18,15 +20,15 @@ Type checkRelopExp(Type type1, Type type2);
 Type checkLogicExp(Type type1, Type type2);
 Type checkConversion(Type target_type, Type type);
 
-Type checkVarDeclaredBeforeUsed(SymTable* symbol_table, const char* name);
-void checkVarNotDeclared(SymTable* symbol_table, const char* name);
-void checkAssign(const char* id_name, Type id_type, Type exp_type);
+Type checkVarDeclaredBeforeUsed(SymTable* symbol_table, NameId name);
+void checkVarNotDeclared(SymTable* symbol_table, NameId name);
+void checkAssign(NameId id_name, Type id_type, Type exp_type);
 
-void handleVarDec(SymTable* symbol_table, const char* name, Type type);
-void handleVarInitialization(SymTable* symbol_table, const char* name, Type type, Type exp_type);
-void handleVarReassign(SymTable* symbol_table, const char* name, Type exp_type);
+void handleVarDec(SymTable* symbol_table, NameId name, Type type);
+void handleVarInitialization(SymTable* symbol_table, NameId name, Type type, Type exp_type);
+void handleVarReassign(SymTable* symbol_table, NameId name, Type exp_type);
 
-SymTableEntry* checkIfLegalCall(SymTable* symbol_table, const char* func_name, vector<ExpInfo*>* args);
+SymTableEntry* checkIfLegalCall(SymTable* symbol_table, NameId func_name, ExpList* args);
 
 void checkBreakInWhile(vector<bool>& in_while);
 void checkContinueInWhile(vector<bool>& in_while);
@@ -34,53 +36,65 @@ void checkContinueInWhile(vector<bool>& in_while);
 void checkEmptyRet(Type last_ret_type);
 void checkExpRet(Type last_ret_type, Type exp_type);
 
-bool checkFormalRedef(vector<string>& arg_names, string& new_arg_name);
-int addFunc(SymTable* symbol_table, const char* func_name, Type ret_type, vector<ArgInfo*>* arg_list, bool is_override);
-void addFuncScope(SymTable* symbol_table, vector<ArgInfo*>* arg_list);
+bool checkFormalRedef(vector<NameId>& arg_names, NameId new_arg_name);
+int addFunc(SymTable* symbol_table, NameId func_name, Type ret_type, ArgList* arg_list, bool is_override);
+void addFuncScope(SymTable* symbol_table, ArgList* arg_list);
 
 void addScope(SymTable* symbol_table);
 void delTopScope(SymTable* symbol_table);
 
-string freshVar();
-string freshGlobalStrVar();
-void assignPlace(ExpInfo* exp_info);
+const string& nameStr(NameId name);
+IRType getIRType(Type type);
+Operand toInt(Operand val);
 
-void emitBinary(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, string op);
-void addDivByZeroCheck(ExpInfo* op2);
-void emitLoadCommand(ExpInfo* target, SymTable* symbol_table, const char* id_name, string& base_ptr);
-void emitNumToPlace(string& place, int val, Type type);
-void emitStrToGlobal(ExpInfo* target, const char* str);
+//constant folding: marks target as a known constant, or evaluates an operation on two known constants
+void setConstPlace(ExpInfo* target, int val);
+bool foldBinary(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, Opcode op);
+bool foldRelop(ExpInfo* op1, ExpInfo* op2, ICmpPred pred, bool& res);
 
-char* copyLabelStr();
+void emitBinary(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, Opcode op);
+//emits the division by zero check of a divisor, returns false when it is a nonzero constant and needs none
+bool addDivByZeroCheck(ExpInfo* op2);
+//turns a bool value into jumping code, leaving the branches on it in truelist and falselist
+void emitJumpOnBool(ExpInfo* target);
+//the condition of an if or a while jumps
+void condAction(ExpInfo* cond);
+void emitLoadCommand(ExpInfo* target, SymTable* symbol_table, NameId id_name);
+void emitNumToPlace(ExpInfo* target, int val);
+void emitStrToGlobal(ExpInfo* target, NameId str);
+
+int copyLabelStr();
 
 void notAction(ExpInfo* target, ExpInfo* op);
-void andAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, const char* label);
-void orAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, const char* label);
-void relopAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, string op);
+void andAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, int label);
+void orAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, int label);
+void relopAction(ExpInfo* target, ExpInfo* op1, ExpInfo* op2, ICmpPred pred);
 void boolAction(ExpInfo* target, bool val);
 void conversionAction(ExpInfo* target, ExpInfo* op, Type target_type);
 
-string getLLVMTypeStr(Type type);
-string createFunc(const char* func_name, Type ret_type, vector<ArgInfo*>* arg_list, int func_idx);
-string getDefaultVal(Type ret_type);
+NameId getFuncIRName(NameId func_name, bool is_main, int func_idx);
+void createFunc(SymTable* symbol_table, NameId func_name, Type ret_type, ArgList* arg_list, int func_idx);
+Operand getDefaultVal(Type ret_type);
 void closeFunc(Type ret_type, StatementInfo* st_info);
 
-void emitVarDec(SymTable* symbol_table, const char* name, Type type, ExpInfo* exp_info, string& base_ptr);
-void emitVarReassign(SymTable* symbol_table, const char* name, ExpInfo* exp_info, string& base_ptr);
+void emitStoreToVar(SymTableEntry* symbol, Operand val);
+void emitVarDec(SymTable* symbol_table, NameId name, Type type, ExpInfo* exp_info);
+void emitVarReassign(SymTable* symbol_table, NameId name, ExpInfo* exp_info);
 void emitRet(ExpInfo* exp_info, Type ret_type);
 
-void ifAction(StatementInfo* target, ExpInfo* exp_info, const char* label, StatementInfo* st_info);
+void ifAction(StatementInfo* target, ExpInfo* exp_info, int label, StatementInfo* st_info);
 void N_Action(StatementInfo* target);
-void ifElseAction(StatementInfo* target, ExpInfo* if_exp, const char* true_label, StatementInfo* if_st, StatementInfo* N_st, char* false_label, StatementInfo* else_st);
-void whileAction(StatementInfo* target, const char* cond_label, ExpInfo* while_exp, const char* body_label, StatementInfo* while_st);
-void statementAction(StatementInfo* target, StatementInfo* st_info, const char* label);
+void ifElseAction(StatementInfo* target, ExpInfo* if_exp, int true_label, StatementInfo* if_st, StatementInfo* N_st, int false_label, StatementInfo* else_st);
+void whileAction(StatementInfo* target, int cond_label, ExpInfo* while_exp, int body_label, StatementInfo* while_st);
+void statementAction(StatementInfo* target, StatementInfo* st_info, int label);
 void breakAction(StatementInfo* st_info);
 void continueAction(StatementInfo* st_info);
-void callAction(SymTable* symbol_table, ExpInfo* target, const char* func_name, vector<ExpInfo*>* args);
-void expCallAction(ExpInfo* target);
+void callAction(SymTable* symbol_table, ExpInfo* target, NameId func_name, ExpList* args);
+//the i1 value of a bool expression used as data, with a phi joining its branches if it was jumping
 void evalBoolExp(ExpInfo* exp_info);
 
-void initCodeBuff();
-void printCodeBuff();
+//emits the runtime functions, or only their declarations when host_runtime is set (for --run)
+void initCodeBuff(bool host_runtime = false);
+void printCodeBuff(ostream& os);
 
 #endif //HW3_BISON_CODE_H
@@ -1,87 +1,348 @@
 #include "bp.hpp"
+#include "Passes.hpp"
+#include "CFG.hpp"
+#include "X86.hpp"
+#include "Compiler.hpp"
 #include <vector>
 #include <iostream>
-#include <sstream>
 using namespace std;
 
-bool replace(string& str, const string& from, const string& to, const BranchLabelIndex index);
-
-CodeBuffer::CodeBuffer() : buffer(), globalDefs() {}
+CodeBuffer::CodeBuffer(CompileStats& stats) : funcs(), strings(), globalDefs(), printed_funcs(), inline_callees(), stream_out(nullptr), globals_printed(false), optimize(true), asm_output(false), stats(stats) {}
 
 CodeBuffer &CodeBuffer::instance() {
-	static CodeBuffer inst;//only instance
-	return inst;
+	return Compiler::current().codeBuffer();
+}
+
+IRFunction& CodeBuffer::func(){
+	return funcs.back();
+}
+
+BasicBlock& CodeBuffer::currBlock(){
+	return func().blocks.back();
+}
+
+void CodeBuffer::streamTo(ostream& os, bool with_globals){
+	stream_out = &os;
+	globals_printed = !with_globals;
+}
+
+void CodeBuffer::setStringBase(int first){
+	strings.first = first;
+}
+
+const IRStrings& CodeBuffer::stringLiterals() const{
+	return strings;
+}
+
+void CodeBuffer::appendPrinted(const string& code, const IRStrings& func_strings){
+	strings.literals.insert(strings.literals.end(), func_strings.literals.begin(), func_strings.literals.end());
+	strings.lengths.insert(strings.lengths.end(), func_strings.lengths.begin(), func_strings.lengths.end());
+	if(!stream_out){
+		printed_funcs.push_back(code);
+		return;
+	}
+	if(!globals_printed){
+		printGlobalBuffer(*stream_out);
+	}
+	*stream_out << code;
+}
+
+void CodeBuffer::openFunc(NameId name, IRType ret_type, const vector<IRType>& arg_types){
+	funcs.push_back(IRFunction());
+	func().name = name;
+	func().ret_type = ret_type;
+	func().arg_types = arg_types;
+	func().blocks.push_back(BasicBlock());
+}
+
+void CodeBuffer::setOptimize(bool enable){
+	optimize = enable;
+}
+
+void CodeBuffer::setAsmOutput(bool enable){
+	asm_output = enable;
+}
+
+void CodeBuffer::printFunc(ostream& os, const IRFunction& f){
+	if(asm_output){
+		printAsmFunction(os, f);
+	} else {
+		printFunction(os, f, strings);
+	}
+}
+
+void CodeBuffer::closeFunc(){
+	if(optimize){
+		PhaseTimer timer(stats, stats.optimize_time);
+		optimizeFunction(func(), inline_callees);
+		if(isInlineCandidate(func())){
+			inline_callees[func().name] = func();
+		}
+	}
+	if(!stream_out){
+		return;
+	}
+
+	PhaseTimer timer(stats, stats.print_time);
+	if(!globals_printed){
+		printGlobalBuffer(*stream_out);
+	}
+	printFunc(*stream_out, func());
+	funcs.clear();
+}
+
+int CodeBuffer::genLabel(){
+	int label = int(func().blocks.size());
+	if(!currBlock().terminated()){
+		emitBr(label);
+	}
+	func().blocks.push_back(BasicBlock());
+	return label;
+}
+
+void CodeBuffer::discardBlocks(int first_block){
+	func().blocks.resize(first_block);
+	for(int succ: successors(currBlock())){
+		if(succ >= first_block){
+			currBlock().instrs.back() = Instr(OP_UNREACHABLE, IR_VOID);
+			break;
+		}
+	}
+}
+
+int CodeBuffer::freshValue(){
+	return func().num_values++;
+}
+
+int CodeBuffer::emit(const Instr &command){
+	stats.instrs_emitted++;
+	if(currBlock().terminated()){
+		func().blocks.push_back(BasicBlock());
+	}
+	currBlock().instrs.push_back(command);
+	return int(func().blocks.size()) - 1;
+}
+
+Operand CodeBuffer::emitValue(Instr command){
+	command.dst = freshValue();
+	emit(command);
+	return Operand::value(command.dst, command.type);
 }
 
-string CodeBuffer::genLabel(){
-	std::stringstream label;
-	label << "label_";
-	label << buffer.size();
-	std::string ret(label.str());
-	label << ":";
-	emit(label.str());
-	return ret;
+Operand CodeBuffer::emitBinop(Opcode op, IRType type, Operand lhs, Operand rhs){
+	Instr command(op, type);
+	command.ops[0] = lhs;
+	command.ops[1] = rhs;
+	return emitValue(command);
 }
 
-int CodeBuffer::emit(const string &s){
-    buffer.push_back(s);
-	return buffer.size() - 1;
+Operand CodeBuffer::emitICmp(ICmpPred pred, Operand lhs, Operand rhs){
+	Instr command(OP_ICMP, IR_I1);
+	command.pred = pred;
+	command.ops[0] = lhs;
+	command.ops[1] = rhs;
+	return emitValue(command);
 }
 
-void CodeBuffer::bpatch(const vector<pair<int,BranchLabelIndex>>& address_list, const std::string &label){
-    for(vector<pair<int,BranchLabelIndex>>::const_iterator i = address_list.begin(); i != address_list.end(); i++){
-    	int address = (*i).first;
-    	BranchLabelIndex labelIndex = (*i).second;
-		replace(buffer[address], "@", "%" + label, labelIndex);
+Operand CodeBuffer::emitCast(Opcode op, IRType type, Operand val){
+	Instr command(op, type);
+	command.ops[0] = val;
+	return emitValue(command);
+}
+
+Operand CodeBuffer::emitAlloca(IRType type){
+	Instr command(OP_ALLOCA, type);
+	command.ops[0] = Operand::constant(1, IR_I32);
+	BasicBlock& entry = func().blocks[0];
+	if(!entry.terminated()){ // the entry block is still the current one
+		return Operand::value(emitValue(command).id, pointerTo(type));
+	}
+	// ahead of the entry block's terminator, where it dominates every block declaring the slot
+	stats.instrs_emitted++;
+	command.dst = freshValue();
+	entry.instrs.insert(entry.instrs.end() - 1, command);
+	return Operand::value(command.dst, pointerTo(type));
+}
+
+Operand CodeBuffer::emitGEP(IRType type, Operand base, Operand index){
+	Instr command(OP_GEP, type);
+	command.ops[0] = base;
+	command.ops[1] = index;
+	Operand ptr = emitValue(command);
+	ptr.type = base.type;
+	return ptr;
+}
+
+Operand CodeBuffer::emitLoad(IRType type, Operand ptr){
+	Instr command(OP_LOAD, type);
+	command.ops[0] = ptr;
+	return emitValue(command);
+}
+
+void CodeBuffer::emitStore(Operand val, Operand ptr){
+	Instr command(OP_STORE, val.type);
+	command.ops[0] = val;
+	command.ops[1] = ptr;
+	emit(command);
+}
+
+Operand CodeBuffer::emitStrPtr(int str_idx){
+	Instr command(OP_STR_PTR, IR_I8_PTR);
+	command.ops[0] = Operand::str(str_idx);
+	return emitValue(command);
+}
+
+Operand CodeBuffer::emitCall(IRType ret_type, NameId callee, const vector<Operand>& args){
+	Instr command(OP_CALL, ret_type);
+	command.ops[0] = Operand::func(callee);
+	command.extra_begin = int(func().extra.size());
+	command.extra_count = int(args.size());
+	func().extra.insert(func().extra.end(), args.begin(), args.end());
+
+	if(ret_type == IR_VOID){
+		emit(command);
+		return Operand();
+	}
+	return emitValue(command);
+}
+
+Operand CodeBuffer::emitPhi(IRType type, const vector<pair<Operand,int>>& incoming){
+	Instr command(OP_PHI, type);
+	command.extra_begin = int(func().extra.size());
+	command.extra_count = int(incoming.size()) * 2;
+	for(auto& in: incoming){
+		func().extra.push_back(in.first);
+		func().extra.push_back(Operand::label(in.second));
+	}
+	return emitValue(command);
+}
+
+int CodeBuffer::emitBr(int label){
+	Instr command(OP_BR, IR_VOID);
+	command.ops[0] = Operand::label(label);
+	return emit(command);
+}
+
+int CodeBuffer::emitCondBr(Operand cond, int true_label, int false_label){
+	Instr command(OP_COND_BR, IR_VOID);
+	command.ops[0] = cond;
+	command.ops[1] = Operand::label(true_label);
+	command.ops[2] = Operand::label(false_label);
+	return emit(command);
+}
+
+void CodeBuffer::convertToCondBr(int block, Operand cond, BranchLabelIndex kept){
+	Instr& branch = func().blocks[block].instrs.back();
+	int target = branch.ops[0].id;
+	branch = Instr(OP_COND_BR, IR_VOID);
+	branch.ops[0] = cond;
+	branch.ops[1] = Operand::label(kept == FIRST ? target : -1);
+	branch.ops[2] = Operand::label(kept == FIRST ? -1 : target);
+}
+
+void CodeBuffer::emitRet(Operand val){
+	Instr command(OP_RET, val.type);
+	command.ops[0] = val;
+	emit(command);
+}
+
+void CodeBuffer::bpatch(const PatchList& address_list, int label){
+    for(PatchNode* i = address_list.head; i; i = i->next){
+    	stats.patches_applied++;
+    	Instr& branch = func().blocks[i->address].instrs.back();
+    	if(branch.op == OP_BR){
+    		branch.ops[0].id = label;
+    	} else { // OP_COND_BR
+    		branch.ops[i->index == FIRST ? 1 : 2].id = label;
+    	}
     }
 }
 
-void CodeBuffer::printCodeBuffer(){
-	for (std::vector<string>::const_iterator it = buffer.begin(); it != buffer.end(); ++it) 
+void CodeBuffer::printCodeBuffer(ostream& os){
+	for(const string& code: printed_funcs){
+		os << code;
+	}
+	for (std::vector<IRFunction>::const_iterator it = funcs.begin(); it != funcs.end(); ++it)
 	{
-		cout << *it << endl;
-    }
+		printFunc(os, *it);
+	}
 }
 
-vector<pair<int,BranchLabelIndex>> CodeBuffer::makelist(pair<int,BranchLabelIndex> item)
+void CodeBuffer::printAll(ostream& os){
+	PhaseTimer timer(stats, stats.print_time);
+	if(!globals_printed){
+		printGlobalBuffer(os);
+	}
+	printCodeBuffer(os);
+	printStringBuffer(os);
+}
+
+PatchList CodeBuffer::makelist(pair<int,BranchLabelIndex> item)
 {
-	vector<pair<int,BranchLabelIndex>> newList;
-	newList.push_back(item);
+	PatchNode* node = new PatchNode();
+	node->address = item.first;
+	node->index = item.second;
+	node->next = nullptr;
+
+	PatchList newList;
+	newList.head = newList.tail = node;
 	return newList;
 }
 
-vector<pair<int,BranchLabelIndex>> CodeBuffer::merge(const vector<pair<int,BranchLabelIndex>> &l1,const vector<pair<int,BranchLabelIndex>> &l2)
+PatchList CodeBuffer::merge(PatchList &l1,PatchList &l2)
 {
-	vector<pair<int,BranchLabelIndex>> newList(l1.begin(),l1.end());
-	newList.insert(newList.end(),l2.begin(),l2.end());
+	PatchList newList;
+	if(l1.empty()){
+		newList = l2;
+	} else if(l2.empty()){
+		newList = l1;
+	} else {
+		l1.tail->next = l2.head;
+		newList.head = l1.head;
+		newList.tail = l2.tail;
+	}
+	l1 = PatchList();
+	l2 = PatchList();
 	return newList;
 }
 
 // ******** Methods to handle the global section ********** //
-void CodeBuffer::emitGlobal(const std::string& dataLine) 
+void CodeBuffer::emitGlobal(const std::string& dataLine)
 {
 	globalDefs.push_back(dataLine);
 }
 
-void CodeBuffer::printGlobalBuffer()
+int CodeBuffer::emitString(const string& literal)
+{
+	// drop the quotes, the array holds the chars and a terminating \00
+	strings.literals.push_back(literal.substr(1, literal.size() - 2));
+	strings.lengths.push_back(int(literal.size()) - 1);
+	return strings.first + int(strings.literals.size()) - 1;
+}
+
+void CodeBuffer::printGlobalBuffer(ostream& os)
 {
+	if(asm_output){
+		// the LLVM definitions are replaced by the assembly runtime
+		printAsmRuntime(os);
+		globals_printed = true;
+		return;
+	}
 	for (vector<string>::const_iterator it = globalDefs.begin(); it != globalDefs.end(); ++it)
 	{
-		cout << *it << endl;
+		os << *it << "\n";
 	}
+	globals_printed = true;
 }
 
-// ******** Helper Methods ********** //
-bool replace(string& str, const string& from, const string& to, const BranchLabelIndex index) {
-	size_t pos;
-	if (index == SECOND) {
-		pos = str.find_last_of(from);
+void CodeBuffer::printStringBuffer(ostream& os)
+{
+	if(asm_output){
+		printAsmStrings(os, strings);
+		return;
 	}
-	else { //FIRST
-		pos = str.find_first_of(from);
+	for (size_t i = 0; i < strings.literals.size(); i++)
+	{
+		os << "@s" << i << " = internal constant [" << strings.lengths[i] << " x i8] c\"" << strings.literals[i] << "\\00\"\n";
 	}
-    if (pos == string::npos)
-        return false;
-    str.replace(pos, from.length(), to);
-    return true;
 }
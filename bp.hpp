@@ -3,6 +3,11 @@
 
 #include <vector>
 #include <string>
+#include <ostream>
+#include "Arena.hpp"
+#include "IR.hpp"
+#include "Passes.hpp"
+#include "CompileStats.hpp"
 
 using namespace std;
 
@@ -10,53 +15,156 @@ using namespace std;
 //for an unconditional branch (which contains only a single label) use FIRST.
 enum BranchLabelIndex {FIRST, SECOND};
 
+//a missing label: the branch terminating basic block address, at label index
+struct PatchNode : public ArenaObject<PatchNode> {
+	int address;
+	BranchLabelIndex index;
+	PatchNode* next;
+};
+
+//intrusive list of {buffer_location, branch_label_index} items waiting for a label.
+//the nodes live in the function's arena, so merging lists is a splice and copying a list is two pointers
+struct PatchList {
+	PatchNode* head;
+	PatchNode* tail;
+
+	PatchList() : head(nullptr), tail(nullptr) {}
+	bool empty() const { return !head; }
+};
+
 class CodeBuffer{
-	CodeBuffer();
+	friend class Compiler;
+	explicit CodeBuffer(CompileStats& stats);
 	CodeBuffer(CodeBuffer const&);
     void operator=(CodeBuffer const&);
-	std::vector<std::string> buffer;
+	std::vector<IRFunction> funcs;
+	IRStrings strings;
 	std::vector<std::string> globalDefs;
+	std::vector<std::string> printed_funcs;
+	//the functions closed so far that are small enough to inline
+	InlineCallees inline_callees;
+	ostream* stream_out;
+	bool globals_printed;
+	bool optimize;
+	bool asm_output;
+	CompileStats& stats;
+
+	//the function being emitted, always funcs.back()
+	IRFunction& func();
+	BasicBlock& currBlock();
+	//prints a complete function in the output format
+	void printFunc(ostream& os, const IRFunction& f);
 public:
+	//the buffer of the current compilation
 	static CodeBuffer &instance();
 
 	// ******** Methods to handle the code section ******** //
 
-	//generates a jump location label for the next command, writes it to the buffer and returns it
-	std::string genLabel();
+	//write each function to os as soon as it is closed instead of keeping it until the end.
+	//the data section is written ahead of the first function (unless with_globals is false), and the
+	//string literals as a trailer by printAll
+	void streamTo(ostream& os, bool with_globals = true);
+
+	//number the string literals from first on, for a function whose literals are merged into another buffer
+	void setStringBase(int first);
+	const IRStrings& stringLiterals() const;
+
+	//adds a function that was compiled and printed by another buffer, with the string literals it uses.
+	//functions are printed in the order they are appended, ahead of the ones compiled here
+	void appendPrinted(const string& code, const IRStrings& func_strings);
+
+	//run the optimization passes on each function as it is closed (on by default)
+	void setOptimize(bool enable);
+
+	//print x86-64 assembly with its own runtime instead of LLVM IR
+	void setAsmOutput(bool enable);
+
+	//starts a new function, the following commands are emitted to its entry block
+	void openFunc(NameId name, IRType ret_type, const vector<IRType>& arg_types);
 
-	//writes command to the buffer, returns its location in the buffer
-	int emit(const std::string &command);
+	//called once all of the function's labels are backpatched, runs the passes over the function
+	void closeFunc();
+
+	//generates a jump location label for the next command, starting a new basic block, and returns it.
+	//if the current block wasn't terminated, it falls through to the new one
+	int genLabel();
+
+	//drops the blocks from first_block to the end, which the caller knows can't be reached.
+	//a branch into them ending the block that is left last is replaced by unreachable
+	void discardBlocks(int first_block);
+
+	//returns a new value id of the current function
+	int freshValue();
+
+	//writes command to the buffer, returns its location in the buffer.
+	//the location is the basic block the command was written to, which is all that bpatch needs since
+	//branches always terminate their block. a command following a terminator opens a new (unreachable) block
+	int emit(const Instr &command);
+
+	//writes a command that defines a new value, and returns that value
+	Operand emitValue(Instr command);
+
+	//helpers that build and emit a single command, returning the value it defines
+	Operand emitBinop(Opcode op, IRType type, Operand lhs, Operand rhs);
+	Operand emitICmp(ICmpPred pred, Operand lhs, Operand rhs);
+	Operand emitCast(Opcode op, IRType type, Operand val);
+	Operand emitGEP(IRType type, Operand base, Operand index);
+	Operand emitLoad(IRType type, Operand ptr);
+	void emitStore(Operand val, Operand ptr);
+	Operand emitStrPtr(int str_idx);
+	Operand emitCall(IRType ret_type, NameId callee, const vector<Operand>& args);
+	Operand emitPhi(IRType type, const vector<pair<Operand,int>>& incoming);
+
+	//allocates a stack slot for one value of type, returning its address. the alloca goes to the entry
+	//block whatever block is current, so the slot is allocated once per call even when declared in a loop
+	Operand emitAlloca(IRType type);
+
+	//emit a branch, a label of -1 is left missing for bpatch. returns the branch's location
+	int emitBr(int label = -1);
+	int emitCondBr(Operand cond, int true_label = -1, int false_label = -1);
+
+	//turns the br ending block into a branch on cond that keeps the br's target at index kept.
+	//the other target is left missing for bpatch
+	void convertToCondBr(int block, Operand cond, BranchLabelIndex kept);
+	void emitRet(Operand val = Operand());
 
 	//gets a pair<int,BranchLabelIndex> item of the form {buffer_location, branch_label_index} and creates a list for it
-	static vector<pair<int,BranchLabelIndex>> makelist(pair<int,BranchLabelIndex> item);
+	static PatchList makelist(pair<int,BranchLabelIndex> item);
 
-	//merges two lists of {buffer_location, branch_label_index} items
-	static vector<pair<int,BranchLabelIndex>> merge(const vector<pair<int,BranchLabelIndex>> &l1,const vector<pair<int,BranchLabelIndex>> &l2);
+	//merges two lists of {buffer_location, branch_label_index} items in O(1).
+	//the items are moved to the returned list, l1 and l2 are left empty
+	static PatchList merge(PatchList &l1,PatchList &l2);
 
 	/* accepts a list of {buffer_location, branch_label_index} items and a label.
-	For each {buffer_location, branch_label_index} item in address_list, backpatches the branch command 
+	For each {buffer_location, branch_label_index} item in address_list, backpatches the branch command
 	at buffer_location, at index branch_label_index (FIRST or SECOND), with the label.
-	note - the function expects to find a '@' char in place of the missing label.
 	note - for unconditional branches (which contain only a single label) use FIRST as the branch_label_index.
 	example #1:
-	int loc1 = emit("br label @");  - unconditional branch missing a label. ~ Note the '@' ~
-	bpatch(makelist({loc1,FIRST}),"my_label"); - location loc1 in the buffer will now contain the command "br label %my_label"
+	int loc1 = emitBr();  - unconditional branch missing a label.
+	bpatch(makelist({loc1,FIRST}),my_label); - location loc1 in the buffer will now contain the command "br label %label_<my_label>"
 	note that index FIRST referes to the one and only label in the line.
 	example #2:
-	int loc2 = emit("br i1 %cond, label @, label @"); - conditional branch missing two labels.
-	bpatch(makelist({loc2,SECOND}),"my_false_label"); - location loc2 in the buffer will now contain the command "br i1 %cond, label @, label %my_false_label"
-	bpatch(makelist({loc2,FIRST}),"my_true_label"); - location loc2 in the buffer will now contain the command "br i1 %cond, label @my_true_label, label %my_false_label"
+	int loc2 = emitCondBr(cond); - conditional branch missing two labels.
+	bpatch(makelist({loc2,SECOND}),my_false_label); - the false target of the branch at loc2 is now my_false_label
+	bpatch(makelist({loc2,FIRST}),my_true_label); - and its true target is my_true_label
 	*/
-	void bpatch(const vector<pair<int,BranchLabelIndex>>& address_list, const std::string &label);
-	
-	//prints the content of the code buffer to stdout
-	void printCodeBuffer();
+	void bpatch(const PatchList& address_list, int label);
+
+	//prints the content of the code buffer to os
+	void printCodeBuffer(ostream& os);
+
+	//prints everything not printed yet: the data section, the code buffer and the string literals
+	void printAll(ostream& os);
 
 	// ******** Methods to handle the data section ******** //
 	//write a line to the global section
 	void emitGlobal(const string& dataLine);
-	//print the content of the global buffer to stdout
-	void printGlobalBuffer();
+	//add a string literal (given with its quotes) to the global section, returns its index
+	int emitString(const string& literal);
+	//print the content of the global buffer to os
+	void printGlobalBuffer(ostream& os);
+	//print the string literals to os
+	void printStringBuffer(ostream& os);
 
 };
 
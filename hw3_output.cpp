@@ -4,12 +4,29 @@
 
 using namespace std;
 
+namespace {
+
+// stream of the compilation running on this thread, cout when none redirected it
+thread_local ostream* out_stream = nullptr;
+
+ostream& out() {
+    return out_stream ? *out_stream : cout;
+}
+
+}
+
+ostream* output::redirect(ostream* os) {
+    ostream* prev = out_stream;
+    out_stream = os;
+    return prev;
+}
+
 void output::endScope(){
-    cout << "---end scope---" << endl;
+    out() << "---end scope---" << endl;
 }
 
 void output::printID(const string& id, int offset, const string& type) {
-    cout << id << " " << type <<  " " << offset <<  endl;
+    out() << id << " " << type <<  " " << offset <<  endl;
 }
 
 string typeListToString(const std::vector<string>& argTypes) {
@@ -43,61 +60,61 @@ string output::makeFunctionType(const string& retType, std::vector<string>& argT
 }
 
 void output::errorLex(int lineno){
-    cout << "line " << lineno << ":" << " lexical error" << endl;
+    out() << "line " << lineno << ":" << " lexical error" << endl;
 }
 
 void output::errorSyn(int lineno){
-    cout << "line " << lineno << ":" << " syntax error" << endl;
+    out() << "line " << lineno << ":" << " syntax error" << endl;
 }
 
 void output::errorUndef(int lineno, const string& id){
-    cout << "line " << lineno << ":" << " variable " << id << " is not defined" << endl;
+    out() << "line " << lineno << ":" << " variable " << id << " is not defined" << endl;
 }
 
 void output::errorDef(int lineno, const string& id){
-    cout << "line " << lineno << ":" << " identifier " << id << " is already defined" << endl;
+    out() << "line " << lineno << ":" << " identifier " << id << " is already defined" << endl;
 }
 
 void output::errorUndefFunc(int lineno, const string& id) {
-    cout << "line " << lineno << ":" << " function " << id << " is not defined" << endl;
+    out() << "line " << lineno << ":" << " function " << id << " is not defined" << endl;
 }
 
 void output::errorMismatch(int lineno){
-    cout << "line " << lineno << ":" << " type mismatch" << endl;
+    out() << "line " << lineno << ":" << " type mismatch" << endl;
 }
 
 void output::errorPrototypeMismatch(int lineno, const string& id) {
-    cout << "line " << lineno << ": prototype mismatch, function " << id << endl;
+    out() << "line " << lineno << ": prototype mismatch, function " << id << endl;
 }
 
 void output::errorUnexpectedBreak(int lineno) {
-    cout << "line " << lineno << ":" << " unexpected break statement" << endl;
+    out() << "line " << lineno << ":" << " unexpected break statement" << endl;
 }
 
 void output::errorUnexpectedContinue(int lineno) {
-    cout << "line " << lineno << ":" << " unexpected continue statement" << endl;	
+    out() << "line " << lineno << ":" << " unexpected continue statement" << endl;	
 }
 
 void output::errorMainMissing() {
-    cout << "Program has no 'void main()' function" << endl;
+    out() << "Program has no 'void main()' function" << endl;
 }
 
 void output::errorByteTooLarge(int lineno, const string& value) {
-    cout << "line " << lineno << ": byte value " << value << " out of range" << endl;
+    out() << "line " << lineno << ": byte value " << value << " out of range" << endl;
 }
 
 void output::errorFuncNoOverride(int lineno, const string& id) {
-    cout << "line " << lineno << ": function " << id << " was declared before as non-override function" << endl;
+    out() << "line " << lineno << ": function " << id << " was declared before as non-override function" << endl;
 }
 
 void output::errorOverrideWithoutDeclaration(int lineno, const string& id) {
-    cout << "line " << lineno << ": function " << id << " attempt to override a function without declaring the current function as override" << endl;
+    out() << "line " << lineno << ": function " << id << " attempt to override a function without declaring the current function as override" << endl;
 }
 
 void output::errorAmbiguousCall(int lineno, const string& id) {
-    cout << "line " << lineno << ": ambiguous call to overloaded function " << id << endl;
+    out() << "line " << lineno << ": ambiguous call to overloaded function " << id << endl;
 }
 
 void output::errorMainOverride(int lineno){
-    cout << "line " << lineno << ": main is not allowed to be overridden" << endl;
+    out() << "line " << lineno << ": main is not allowed to be overridden" << endl;
 }
\ No newline at end of file
@@ -3,9 +3,13 @@
 
 #include <vector>
 #include <string>
+#include <ostream>
 using namespace std;
 
 namespace output{
+    //sends the messages printed on the calling thread to os (cout for nullptr), returns the previous stream
+    ostream* redirect(ostream* os);
+
     void endScope();
     void printID(const string& id, int offset, const string& type);
 
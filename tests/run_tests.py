@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Regression tests: the output of programs compiled by hw5.
+
+    run_tests.py [--asm] [hw5] [case.in ...]
+
+Every case (tests/*/*.in by default) is compiled by hw5 and its output compared with case.out: the
+diagnostic for a program with an error, otherwise what the program prints when its IR is run through
+lli (or its --asm executable, built with $CC). A case is compiled twice, once from the file itself,
+which hw5 maps and scans with its fast scanner, and once piped through stdin, which the flex scanner
+of scanner.lex reads, so the two scanners are held to the same expected output.
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def compileCase(hw5, case, piped, asm):
+    cmd = [hw5] + (["--asm"] if asm else [])
+    with open(case, "rb") as source:
+        if piped:
+            proc = subprocess.run(cmd, input=source.read(), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        else:
+            proc = subprocess.run(cmd, stdin=source, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    return proc.stdout
+
+
+def runCode(code, asm, work, cc):
+    # a diagnostic is the output as it is
+    if code.startswith(b"line ") or code.startswith(b"Program has no"):
+        return code
+    if asm:
+        path = os.path.join(work, "case.s")
+        with open(path, "wb") as out:
+            out.write(code)
+        subprocess.run([cc, path, "-o", os.path.join(work, "case")], check=True)
+        cmd = [os.path.join(work, "case")]
+    else:
+        path = os.path.join(work, "case.ll")
+        with open(path, "wb") as out:
+            out.write(code)
+        cmd = ["lli", path]
+    return subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, timeout=60).stdout
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hw5", nargs="?", default="./hw5")
+    parser.add_argument("cases", nargs="*")
+    parser.add_argument("--asm", action="store_true", help="run the --asm executables instead of lli")
+    args = parser.parse_args()
+
+    cases = args.cases or sorted(glob.glob(os.path.join(TESTS_DIR, "*", "*.in")))
+    cc = os.environ.get("CC", "cc")
+    failed = []
+    with tempfile.TemporaryDirectory() as work:
+        for case in cases:
+            name = os.path.relpath(case, TESTS_DIR)
+            with open(os.path.splitext(case)[0] + ".out", "rb") as expected_file:
+                expected = expected_file.read()
+            for piped in (False, True):
+                output = runCode(compileCase(args.hw5, case, piped, args.asm), args.asm, work, cc)
+                if output != expected:
+                    how = "piped" if piped else "from the file"
+                    failed.append(name)
+                    print("FAIL {} ({}):\n{}".format(name, how, output.decode("latin1")[:500]))
+                    break
+    print("{} of {} cases passed".format(len(cases) - len(failed), len(cases)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())